@@ -0,0 +1,351 @@
+////////////////////////////////////////////////////////////////////////
+//
+//  serve NullAnnotator runs over a local socket, keeping dependency
+//  results and solved call graph components resident between requests
+//
+//  Each connection carries one request, a single line of words
+//  separated by whitespace:
+//
+//      analyze module.bc module.json ...
+//
+//  names a bitcode file and then any iiglue results files for it, as
+//  seen from the server; the reply is "ok" on a line by itself followed
+//  by the results in the "-output-format" format.
+//
+//      query module.bc function module.json ...
+//
+//  does the same for just the named function, solving only it and the
+//  functions it transitively calls, as an editor asking about one
+//  function at a time would want.
+//
+//      quit
+//
+//  replies "ok" and stops the server once requests in progress finish.
+//  Any failure replies "error: " and a message on one line instead,
+//  including a request line not sent within "-request-timeout"
+//  seconds of connecting.
+//
+//  Dependencies come from "-dependency" files, read once at startup.
+//  Components solved for one request are reused by any later request
+//  with identical code and callee results, as with
+//  "-null-annotator-cache", but only in memory.
+//
+
+#include "Dependencies.hh"
+#include "IIGlueReader.hh"
+#include "IncrementalCache.hh"
+#include "NullAnnotator.hh"
+#include "Parallel.hh"
+#include "Trace.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/PassManager.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::opt<string>
+	socketPath(cl::Positional,
+		cl::Required,
+		cl::value_desc("socket"),
+		cl::desc("<socket>"));
+
+static cl::opt<unsigned>
+	jobCount("jobs",
+		cl::init(max(1u, thread::hardware_concurrency())),
+		cl::value_desc("count"),
+		cl::desc("Number of requests to serve at once"));
+
+static cl::opt<unsigned>
+	requestTimeout("request-timeout",
+		cl::init(30),
+		cl::value_desc("seconds"),
+		cl::desc("Drop clients that take longer than this to send a request; 0 waits forever"));
+
+// longest request line accepted
+static const size_t requestLimit = 1 << 16;
+
+
+namespace {
+	// closes a socket when done with it
+	class Descriptor {
+	public:
+		explicit Descriptor(int);
+		~Descriptor();
+		Descriptor(const Descriptor &) = delete;
+		Descriptor &operator=(const Descriptor &) = delete;
+		const int fd;
+	};
+
+	class Server {
+	public:
+		Server(const Dependencies &, int listener);
+		void serve();
+
+	private:
+		const Dependencies &dependencies;
+		IncrementalCache cache;
+		const int listener;
+		atomic<bool> stopping;
+
+		void respond(int connection);
+		string analyze(const string &bitcode, vector<string> iiglue, vector<string> queries);
+		void stop();
+	};
+}
+
+
+static system_error systemError(const string &what) {
+	return system_error(errno, system_category(), what);
+}
+
+
+inline Descriptor::Descriptor(int fd)
+	: fd(fd) {
+}
+
+
+inline Descriptor::~Descriptor() {
+	if (fd >= 0)
+		close(fd);
+}
+
+
+static string receiveLine(int connection) {
+	string line;
+	char buffer[4096];
+	while (line.find('\n') == string::npos) {
+		if (line.size() > requestLimit)
+			throw runtime_error("request too long");
+		const ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+		if (received < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				throw runtime_error("timed out waiting for request");
+			throw systemError("cannot read request");
+		}
+		if (received == 0)
+			break;
+		line.append(buffer, received);
+	}
+	return line.substr(0, line.find('\n'));
+}
+
+
+static void sendAll(int connection, StringRef data) {
+	while (!data.empty()) {
+		const ssize_t sent = send(connection, data.data(), data.size(), 0);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			throw systemError("cannot send reply");
+		}
+		data = data.drop_front(sent);
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+Server::Server(const Dependencies &dependencies, int listener)
+	: dependencies(dependencies),
+	  listener(listener),
+	  stopping(false) {
+}
+
+
+// one accept loop per worker thread
+void Server::serve() {
+	// warn once each time descriptors run out, not on every retry
+	bool starved = false;
+	while (!stopping) {
+		const Descriptor connection(accept(listener, nullptr, nullptr));
+		if (connection.fd < 0) {
+			if (stopping)
+				break;
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			// out of descriptors is transient: requests in progress
+			// will soon release theirs
+			if (errno == EMFILE || errno == ENFILE) {
+				if (!starved)
+					errs() << "warning: " << systemError("cannot accept connection").what() << "; retrying\n";
+				starved = true;
+				this_thread::sleep_for(chrono::milliseconds(100));
+				continue;
+			}
+			errs() << "warning: " << systemError("cannot accept connection").what() << '\n';
+			stop();
+			break;
+		}
+		starved = false;
+
+		// a client that never finishes its request must not hold this
+		// thread forever
+		if (requestTimeout) {
+			const timeval timeout = { time_t(requestTimeout), 0 };
+			if (setsockopt(connection.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+				errs() << "warning: " << systemError("cannot limit request time").what() << '\n';
+				continue;
+			}
+		}
+		respond(connection.fd);
+	}
+}
+
+
+void Server::respond(int connection) {
+	string reply;
+	bool quitting = false;
+	try {
+		istringstream words(receiveLine(connection));
+		string command, bitcode;
+		words >> command;
+		if (command == "analyze" || command == "query") {
+			if (!(words >> bitcode))
+				throw runtime_error("no bitcode file to analyze");
+			vector<string> queries(command == "query");
+			if (!queries.empty() && !(words >> queries.front()))
+				throw runtime_error("no function to query");
+			vector<string> iiglue;
+			for (string file; words >> file; )
+				iiglue.push_back(file);
+			reply = "ok\n" + analyze(bitcode, std::move(iiglue), std::move(queries));
+		} else if (command == "quit") {
+			reply = "ok\n";
+			quitting = true;
+		} else
+			throw runtime_error("unknown request \"" + command + '"');
+	} catch (const exception &error) {
+		string message = error.what();
+		replace(message.begin(), message.end(), '\n', ' ');
+		reply = "error: " + message + '\n';
+	}
+
+	// a client hanging up early affects only its own request
+	try {
+		sendAll(connection, reply);
+	} catch (const system_error &error) {
+		errs() << "warning: " << error.what() << '\n';
+	}
+	if (quitting)
+		stop();
+}
+
+
+// requests share nothing but dependencies and the cache, so each gets
+// its own context and pass instances
+string Server::analyze(const string &bitcode, vector<string> iiglue, vector<string> queries) {
+	const TraceScope tracing("serve request", bitcode);
+	LLVMContext context;
+	SMDiagnostic diagnostic;
+	const unique_ptr<Module> module(ParseIRFile(bitcode, diagnostic, context));
+	if (!module)
+		throw runtime_error(bitcode + ": " + diagnostic.getMessage().str());
+	for (const string &name : queries)
+		if (!module->getFunction(name))
+			throw runtime_error("no function " + name + " in " + bitcode);
+
+	// exceptions must not unwind through the pass manager, so read
+	// iiglue results, which may be malformed, before running it
+	unique_ptr<IIGlueReader> reader(new IIGlueReader(std::move(iiglue)));
+	reader->read(*module);
+
+	string results;
+	{
+		raw_string_ostream out(results);
+		PassManager passes;
+		passes.add(reader.release());
+		passes.add(createNullAnnotator(dependencies, out, &cache, std::move(queries)));
+		passes.run(*module);
+	}
+	return results;
+}
+
+
+// wakes every thread blocked in accept()
+void Server::stop() {
+	stopping = true;
+	shutdown(listener, SHUT_RDWR);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+int main(int argc, char *argv[]) {
+	// write statistics and traces when finished
+	const llvm_shutdown_obj shutdown;
+	cl::ParseCommandLineOptions(argc, argv, "serve NullAnnotator results over a Unix socket\n");
+
+#if (1000 * LLVM_VERSION_MAJOR + LLVM_VERSION_MINOR) < 3005
+	// LLVM 3.4 only guards its global state once told to
+	llvm_start_multithreaded();
+#endif	// LLVM 3.4 or earlier
+
+	// clients hanging up must not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	try {
+		Dependencies dependencies;
+		dependencies.readCommandLine();
+
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (socketPath.size() >= sizeof(address.sun_path))
+			throw runtime_error("socket path too long: " + socketPath);
+		strcpy(address.sun_path, socketPath.c_str());
+
+		const Descriptor listener(socket(AF_UNIX, SOCK_STREAM, 0));
+		if (listener.fd < 0)
+			throw systemError("cannot create socket");
+		// a socket left by an earlier server would block bind(), but
+		// anything else at that path is not ours to remove
+		struct stat existing;
+		if (lstat(socketPath.c_str(), &existing) == 0) {
+			if (!S_ISSOCK(existing.st_mode))
+				throw runtime_error(socketPath + " exists and is not a socket");
+			if (unlink(socketPath.c_str()) < 0)
+				throw systemError("cannot remove stale socket " + socketPath);
+		} else if (errno != ENOENT)
+			throw systemError("cannot check " + socketPath);
+		if (bind(listener.fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+			throw systemError("cannot bind " + socketPath);
+		if (listen(listener.fd, SOMAXCONN) < 0)
+			throw systemError("cannot listen on " + socketPath);
+
+		Server server(dependencies, listener.fd);
+		parallelFor(jobCount, jobCount, [&](size_t) { server.serve(); });
+		unlink(socketPath.c_str());
+	} catch (const exception &error) {
+		errs() << argv[0] << ": " << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,241 @@
+////////////////////////////////////////////////////////////////////////
+//
+//  run NullAnnotator over many modules in one process, loading
+//  dependency results once and analyzing modules concurrently
+//
+//  Each manifest line names a bitcode file, the file to write its
+//  results to or "-" for none, and then any iiglue results files for
+//  that module, all separated by whitespace.  A lone ":" may follow,
+//  and then the bitcode files of libraries this module depends on,
+//  each from some earlier line:
+//
+//      glib.bc     answers-glib.json     glib.json
+//      gobject.bc  answers-gobject.json  gobject.json  :  glib.bc
+//
+//  A module is analyzed only once all of its dependencies are done,
+//  and starts from their final results, passed along in memory rather
+//  than through files.  Modules not waiting on each other run
+//  concurrently.  Blank lines and lines starting with '#' are ignored.
+//  Other options, such as "-dependency", "-output-format" or
+//  "-overreport", apply to every module.
+//
+//  With "-summarize-locally", each module's local summaries are written
+//  instead, as phase one of a two-phase analysis finished by
+//  solve-summaries.
+//
+
+#include "Dependencies.hh"
+#include "IIGlueReader.hh"
+#include "LocalSummaries.hh"
+#include "NullAnnotator.hh"
+#include "OutputFile.hh"
+#include "Parallel.hh"
+#include "SummaryFile.hh"
+#include "Trace.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <stdexcept>
+#include <thread>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/PassManager.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::opt<string>
+	manifestFileName(cl::Positional,
+		cl::Required,
+		cl::value_desc("manifest"),
+		cl::desc("<manifest>"));
+
+static cl::opt<unsigned>
+	jobCount("jobs",
+		cl::init(max(1u, thread::hardware_concurrency())),
+		cl::value_desc("count"),
+		cl::desc("Number of modules to analyze at once"));
+
+static cl::opt<bool>
+	summarizeLocally("summarize-locally",
+		cl::desc("Write each module's local summaries, for solve-summaries, instead of NullAnnotator results"));
+
+
+namespace {
+	struct Job {
+		string bitcode;
+		string output;
+		vector<string> iiglue;
+		// earlier jobs whose results this one starts from
+		vector<unsigned> dependencies;
+	};
+}
+
+
+static vector<Job> readManifest(const string &filename) {
+	ifstream manifest(filename);
+	if (!manifest)
+		throw runtime_error("cannot read manifest " + filename);
+
+	vector<Job> jobs;
+	unordered_map<string, unsigned> jobForBitcode;
+	unsigned lineNumber = 0;
+	for (string line; getline(manifest, line); ) {
+		++lineNumber;
+		const string where = filename + ':' + to_string(lineNumber) + ": ";
+		istringstream fields(line);
+		Job job;
+		if (!(fields >> job.bitcode) || job.bitcode[0] == '#')
+			continue;
+		if (!(fields >> job.output))
+			throw runtime_error(where + "no output file for " + job.bitcode);
+		if (job.output == "-")
+			job.output.clear();
+
+		string field;
+		while (fields >> field && field != ":")
+			job.iiglue.push_back(field);
+		while (fields >> field) {
+			const auto found = jobForBitcode.find(field);
+			if (found == jobForBitcode.end())
+				throw runtime_error(where + "dependency " + field + " is not on any earlier line");
+			job.dependencies.push_back(found->second);
+		}
+
+		if (!jobForBitcode.insert({ job.bitcode, unsigned(jobs.size()) }).second)
+			throw runtime_error(where + job.bitcode + " is listed more than once");
+		jobs.push_back(std::move(job));
+	}
+	return jobs;
+}
+
+
+// analyses of different modules share nothing but the dependencies,
+// so each gets its own context and pass instances
+static void analyze(const Job &job, const Dependencies &dependencies, vector<SummaryFile::Summary> *summaries) {
+	const TraceScope tracing("analyze module", job.bitcode);
+	LLVMContext context;
+	SMDiagnostic diagnostic;
+	const unique_ptr<Module> module(ParseIRFile(job.bitcode, diagnostic, context));
+	if (!module)
+		throw runtime_error(diagnostic.getMessage().str());
+
+	// exceptions must not unwind through the pass manager, so do
+	// everything that can fail for want of good inputs here, first;
+	// dependencies were checked as they were loaded
+	unique_ptr<IIGlueReader> iiglue(new IIGlueReader(job.iiglue));
+	iiglue->read(*module);
+	unique_ptr<raw_fd_ostream> output;
+	if (!job.output.empty())
+		output = openOutputFile(job.output);
+
+	PassManager passes;
+	passes.add(iiglue.release());
+	if (summarizeLocally)
+		passes.add(createLocalSummaries(output.get()));
+	else
+		passes.add(createNullAnnotator(dependencies, output.get(), summaries));
+	passes.run(*module);
+}
+
+
+int main(int argc, char *argv[]) {
+	// write statistics and traces when finished
+	const llvm_shutdown_obj shutdown;
+	cl::ParseCommandLineOptions(argc, argv, "analyze many bitcode modules with NullAnnotator\n");
+
+#if (1000 * LLVM_VERSION_MAJOR + LLVM_VERSION_MINOR) < 3005
+	// LLVM 3.4 only guards its global state once told to
+	llvm_start_multithreaded();
+#endif	// LLVM 3.4 or earlier
+
+	vector<Job> jobs;
+	Dependencies shared;
+	try {
+		jobs = readManifest(manifestFileName);
+		shared.readCommandLine();
+	} catch (const exception &error) {
+		errs() << argv[0] << ": " << error.what() << '\n';
+		return 1;
+	}
+
+	// dependencies always come from earlier lines, so this is a DAG
+	const unsigned total = jobs.size();
+	vector<vector<unsigned>> dependents(total);
+	vector<unsigned> pending(total);
+	for (unsigned index = 0; index < total; ++index) {
+		pending[index] = jobs[index].dependencies.size();
+		for (const unsigned dependency : jobs[index].dependencies)
+			dependents[dependency].push_back(index);
+	}
+
+	// each finished job's results, held only until its last dependent
+	// has started from them
+	vector<Dependencies> finished(total);
+	vector<unsigned> unstarted(total);
+	for (unsigned index = 0; index < total; ++index)
+		unstarted[index] = dependents[index].size();
+
+	// one failed module should not stop the others, but does stop
+	// anything depending on it
+	mutex lock;
+	vector<bool> failed(total);
+	unsigned failures = 0;
+	const auto fail = [&](unsigned index, const string &message) {
+		const lock_guard<mutex> locked(lock);
+		failed[index] = true;
+		++failures;
+		errs() << argv[0] << ": " << jobs[index].bitcode << ": " << message << '\n';
+	};
+
+	parallelTopological(jobCount, dependents, std::move(pending), [&](unsigned index) {
+			const Job &job = jobs[index];
+			Dependencies dependencies(shared);
+			const string *blocked = nullptr;
+			{
+				const lock_guard<mutex> locked(lock);
+				for (const unsigned dependency : job.dependencies) {
+					if (failed[dependency])
+						blocked = &jobs[dependency].bitcode;
+					else
+						dependencies.include(finished[dependency]);
+					if (--unstarted[dependency] == 0)
+						finished[dependency] = Dependencies();
+				}
+			}
+			if (blocked) {
+				fail(index, "skipped because " + *blocked + " failed");
+				return;
+			}
+
+			vector<SummaryFile::Summary> summaries;
+			try {
+				analyze(job, dependencies, dependents[index].empty() ? nullptr : &summaries);
+			} catch (const exception &error) {
+				fail(index, error.what());
+				return;
+			}
+
+			if (!dependents[index].empty()) {
+				const lock_guard<mutex> locked(lock);
+				finished[index].add(job.bitcode, std::move(summaries));
+			}
+		});
+
+	if (failures) {
+		errs() << argv[0] << ": " << failures << " of " << total << " modules failed\n";
+		return 1;
+	}
+	return 0;
+}
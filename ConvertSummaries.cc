@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////
+//
+//  convert NullAnnotator JSON results, such as answers-glib.json or
+//  cLibrary.json, into the binary form read by SummaryFile
+//
+
+#include "SummaryFile.hh"
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::opt<string>
+	inputFileName(cl::Positional,
+		cl::Required,
+		cl::value_desc("input.json"),
+		cl::desc("<input.json>"));
+
+static cl::opt<string>
+	outputFileName(cl::Positional,
+		cl::Required,
+		cl::value_desc("output.summary"),
+		cl::desc("<output.summary>"));
+
+
+int main(int argc, char *argv[]) {
+	cl::ParseCommandLineOptions(argc, argv, "convert NullAnnotator JSON results to binary summaries\n");
+	try {
+		SummaryFile::write(outputFileName, SummaryFile::readJSON(inputFileName));
+	} catch (const exception &error) {
+		errs() << argv[0] << ": " << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include "Counters.hh"
+#include "OutputFile.hh"
+
+#include <boost/range/adaptor/indirected.hpp>
+#include <map>
+#include <string>
+#include <system_error>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::opt<string>
+	statsFileName("stats-json",
+		cl::Optional,
+		cl::value_desc("filename"),
+		cl::desc("File to write analysis counters and peak memory use to, as JSON, when finished"));
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  every measure ever defined; like LLVM's own statistics, torn down
+//  and reported from llvm_shutdown(), while all measures still exist
+//
+
+class MeasureRegistry {
+public:
+	~MeasureRegistry();
+	void add(const Measure &);
+
+private:
+	vector<const Measure *> measures;
+	void write(raw_ostream &) const;
+};
+
+
+static ManagedStatic<MeasureRegistry> registry;
+
+
+MeasureRegistry::~MeasureRegistry() {
+	if (statsFileName.empty()) return;
+	try {
+		write(*openOutputFile(statsFileName));
+	} catch (const system_error &error) {
+		errs() << "warning: " << error.what() << '\n';
+	}
+}
+
+
+void MeasureRegistry::add(const Measure &measure) {
+	measures.push_back(&measure);
+}
+
+
+void MeasureRegistry::write(raw_ostream &out) const {
+	// group and sort by name for stable output
+	typedef map<string, map<string, uint64_t>> Groups;
+	Groups counts, peaks;
+	for (const Measure &measure : measures | boost::adaptors::indirected)
+		(measure.memory ? peaks : counts)[measure.group][measure.name] = measure.current;
+
+	const auto writeGroups = [&](const char key[], const Groups &groups) {
+		out << "\t\"" << key << "\": {";
+		for (const auto &group : groups) {
+			out << (&group == &*groups.begin() ? "\n" : ",\n")
+			    << "\t\t\"" << group.first << "\": {";
+			for (const auto &value : group.second)
+				out << (&value == &*group.second.begin() ? "\n" : ",\n")
+				    << "\t\t\t\"" << value.first << "\": " << value.second;
+			out << "\n\t\t}";
+		}
+		out << "\n\t}";
+	};
+
+	out << "{\n";
+	writeGroups("counters", counts);
+	out << ",\n";
+	writeGroups("peak-bytes", peaks);
+	out << "\n}\n";
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+Measure::Measure(const char group[], const char name[], bool memory)
+	: current(0),
+	  group(group),
+	  name(name),
+	  memory(memory) {
+	registry->add(*this);
+}
+
+
+Counter::Counter(const char group[], const char name[])
+	: Measure(group, name, false) {
+}
+
+
+MemoryGauge::MemoryGauge(const char group[], const char name[])
+	: Measure(group, name, true) {
+}
@@ -0,0 +1,110 @@
+#ifndef INCLUDE_COUNTERS_HH
+#define INCLUDE_COUNTERS_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  named event counts and memory gauges, grouped by pass
+//
+//  Unlike STATISTIC, these stay enabled in release builds of LLVM, so
+//  they are this plugin's only counters.  Define each one as a static
+//  object, as with STATISTIC; all of them are written as JSON when LLVM
+//  shuts down, if "-stats-json" names a file.  Updates are atomic, so
+//  concurrent solvers may share them.
+//
+//  Counts add up over every pass instance in the process.  A gauge
+//  instead keeps the most bytes any one pass instance ever held, so
+//  drivers analyzing many modules at once report the largest module's
+//  footprint rather than a mix of several.
+//
+
+class Measure {
+public:
+	Measure(const Measure &) = delete;
+	Measure &operator=(const Measure &) = delete;
+
+protected:
+	Measure(const char group[], const char name[], bool memory);
+	// count so far, or peak bytes so far for gauges
+	std::atomic<uint64_t> current;
+
+private:
+	friend class MeasureRegistry;
+	const char * const group;
+	const char * const name;
+	const bool memory;
+};
+
+
+class Counter : public Measure {
+public:
+	Counter(const char group[], const char name[]);
+	Counter &operator++();
+	Counter &operator+=(uint64_t);
+};
+
+
+// most bytes some table of any one pass instance ever held; each
+// instance tracks its own total and reports it after every change
+class MemoryGauge : public Measure {
+public:
+	MemoryGauge(const char group[], const char name[]);
+	void observe(uint64_t bytes);
+};
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  heap bytes held directly by standard containers, not counting
+//  anything their elements point to; node sizes are estimates
+//
+
+template <typename T>
+size_t heapBytes(const std::vector<T> &elements) {
+	return elements.capacity() * sizeof(T);
+}
+
+
+template <typename Key, typename Value, typename... Rest>
+size_t heapBytes(const std::unordered_map<Key, Value, Rest...> &table) {
+	typedef typename std::unordered_map<Key, Value, Rest...>::value_type Element;
+	return table.bucket_count() * sizeof(void *) + table.size() * (sizeof(Element) + 2 * sizeof(void *));
+}
+
+
+template <typename Key, typename... Rest>
+size_t heapBytes(const std::unordered_set<Key, Rest...> &table) {
+	return table.bucket_count() * sizeof(void *) + table.size() * (sizeof(Key) + 2 * sizeof(void *));
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline Counter &Counter::operator++() {
+	current.fetch_add(1, std::memory_order_relaxed);
+	return *this;
+}
+
+
+inline Counter &Counter::operator+=(uint64_t amount) {
+	current.fetch_add(amount, std::memory_order_relaxed);
+	return *this;
+}
+
+
+inline void MemoryGauge::observe(uint64_t bytes) {
+	uint64_t seen = current.load(std::memory_order_relaxed);
+	while (bytes > seen && !current.compare_exchange_weak(seen, bytes, std::memory_order_relaxed))
+		;
+}
+
+
+#endif // !INCLUDE_COUNTERS_HH
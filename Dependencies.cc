@@ -0,0 +1,123 @@
+#include "Dependencies.hh"
+#include "Trace.hh"
+
+#include <boost/range/adaptor/indirected.hpp>
+#include <boost/range/adaptor/reversed.hpp>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::list<string>
+	dependencyFileNames("dependency",
+		cl::ZeroOrMore,
+		cl::value_desc("filename"),
+		cl::desc("Filename containing NullAnnotator results for dependencies, as JSON or binary summary; use multiple times to read multiple files"));
+
+
+Dependencies::Source::Source(string origin, unique_ptr<SummaryFile> binary, vector<SummaryFile::Summary> summaries)
+	: origin(std::move(origin)),
+	  binary(std::move(binary)) {
+	// the first of several results for one name wins, as binary
+	// summary lookups find the first and solve-summaries resolves
+	// calls to the first definition
+	for (SummaryFile::Summary &summary : summaries) {
+		if (index.insert({ summary.name, unsigned(this->summaries.size()) }).second)
+			this->summaries.push_back(std::move(summary));
+		else
+			errs() << "warning: function " << summary.name << " listed more than once in "
+			       << this->origin << "; using the first\n";
+	}
+}
+
+
+void Dependencies::readCommandLine() {
+	for (const string &dependency : dependencyFileNames)
+		read(dependency);
+}
+
+
+void Dependencies::read(const string &filename) {
+	const TraceScope tracing("read dependency results", filename);
+	if (SummaryFile::recognize(filename))
+		sources.push_back(make_shared<Source>(filename, unique_ptr<SummaryFile>(new SummaryFile(filename)), vector<SummaryFile::Summary>()));
+	else
+		sources.push_back(make_shared<Source>(filename, nullptr, SummaryFile::readJSON(filename)));
+}
+
+
+void Dependencies::add(const string &origin, vector<SummaryFile::Summary> summaries) {
+	sources.push_back(make_shared<Source>(origin, nullptr, std::move(summaries)));
+}
+
+
+void Dependencies::include(const Dependencies &other) {
+	sources.insert(sources.end(), other.sources.begin(), other.sources.end());
+}
+
+
+void Dependencies::apply(const Module &module, const Found &found) const {
+	for (const Source &source : sources | boost::adaptors::indirected) {
+		if (source.binary) {
+			// binary summaries are indexed by name, so only look up
+			// functions this module actually has
+			for (const Function &function : module) {
+				ArrayRef<uint8_t> answers;
+				if (!source.binary->lookup(function.getName(), answers))
+					continue;
+
+				if (function.arg_size() != answers.size()) {
+					errs() << "Warning: Arity mismatch between function " << function.getName()
+					       << " in the summary file provided: " << source.origin
+					       << " and the one found in the bitcode. Skipping.\n";
+					continue;
+				}
+				found(function, answers);
+			}
+			continue;
+		}
+
+		for (const SummaryFile::Summary &summary : source.summaries) {
+			// find corresponding LLVM function object
+			const Function * const function = module.getFunction(summary.name);
+			if (!function) {
+				errs() << "warning: found function " << summary.name << " in dependency results "
+				       << source.origin << " but not in bitcode\n";
+				continue;
+			}
+
+			if (function->arg_size() != summary.answers.size()) {
+				errs() << "Warning: Arity mismatch between function " << summary.name
+				       << " in the .json file provided: " << source.origin
+				       << " and the one found in the bitcode. Skipping.\n";
+				continue;
+			}
+			found(*function, summary.answers);
+		}
+	}
+}
+
+
+bool Dependencies::lookup(StringRef name, size_t arity, ArrayRef<uint8_t> &answers) const {
+	for (const Source &source : sources | boost::adaptors::reversed | boost::adaptors::indirected) {
+		if (source.binary) {
+			if (!source.binary->lookup(name, answers))
+				continue;
+		} else {
+			const auto found = source.index.find(name);
+			if (found == source.index.end())
+				continue;
+			answers = source.summaries[found->second].answers;
+		}
+
+		if (answers.size() == arity)
+			return true;
+		errs() << "Warning: Arity mismatch between function " << name
+		       << " in the results provided: " << source.origin
+		       << " and the one being solved. Skipping.\n";
+	}
+	return false;
+}
@@ -0,0 +1,70 @@
+#ifndef INCLUDE_DEPENDENCIES_HH
+#define INCLUDE_DEPENDENCIES_HH
+
+#include "SummaryFile.hh"
+
+#include <llvm/ADT/StringMap.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+	class Function;
+	class Module;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  NullAnnotator results for libraries a module depends on
+//
+//  Each source is loaded once, either from a JSON or binary summary
+//  file or directly from results computed in this process, and can
+//  then seed any number of NullAnnotator runs.  Applying results
+//  never changes anything here, so concurrent runs may share one
+//  instance.  Copies share loaded sources rather than duplicating
+//  them.
+//
+
+class Dependencies {
+public:
+	// read files named with "-dependency", in order
+	void readCommandLine();
+
+	// read one JSON or binary summary file; if a file lists one
+	// function more than once, the first listing wins
+	void read(const std::string &filename);
+
+	// take results computed in this process; origin names them in
+	// warnings
+	void add(const std::string &origin, std::vector<SummaryFile::Summary>);
+
+	// share every source of another instance, after those already here
+	void include(const Dependencies &);
+
+	// call found(function, answers) for each function of module with
+	// matching results, source by source, so later sources override
+	// earlier ones; functions with mismatched arity are skipped
+	typedef std::function<void(const llvm::Function &, llvm::ArrayRef<uint8_t>)> Found;
+	void apply(const llvm::Module &, const Found &) const;
+
+	// results for one function with the given arity, from the latest
+	// source having any, for solving without a module
+	bool lookup(llvm::StringRef name, size_t arity, llvm::ArrayRef<uint8_t> &answers) const;
+
+private:
+	struct Source {
+		std::string origin;
+		std::unique_ptr<SummaryFile> binary;
+		std::vector<SummaryFile::Summary> summaries;
+		// position of each function in summaries
+		llvm::StringMap<unsigned> index;
+		Source(std::string origin, std::unique_ptr<SummaryFile>, std::vector<SummaryFile::Summary>);
+	};
+	std::vector<std::shared_ptr<const Source>> sources;
+};
+
+
+#endif // !INCLUDE_DEPENDENCIES_HH
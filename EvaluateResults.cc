@@ -0,0 +1,364 @@
+////////////////////////////////////////////////////////////////////////
+//
+//  score NullAnnotator results against expected answers, as
+//  NullAnnotatorSummary.py does, for many pairs of files at once
+//
+//  Arguments alternate between results and answers files, either in
+//  JSON or JSON Lines format.  Each answers file is loaded into a
+//  table, but each results file is only streamed past it.  Reports
+//  print in the order given, however many pairs are scored at once;
+//  a pair that cannot be scored prints only its error.
+//
+
+#include "JSONScanner.hh"
+#include "MappedFile.hh"
+#include "Parallel.hh"
+
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::list<string>
+	fileNames(cl::Positional,
+		cl::OneOrMore,
+		cl::value_desc("files"),
+		cl::desc("<results.json answers.json>..."));
+
+static cl::opt<unsigned>
+	jobCount("jobs",
+		cl::init(1),
+		cl::value_desc("count"),
+		cl::desc("Number of results files to score at once"));
+
+static cl::opt<bool>
+	listMismatches("list-mismatches",
+		cl::desc("List every false positive and false negative"));
+
+
+namespace {
+	// the parts of one function's record that scoring looks at
+	struct FunctionRecord {
+		vector<int64_t> annotations;
+		vector<int64_t> arrays;
+		vector<string> names;
+		vector<string> reasons;
+	};
+
+	// running totals for one pair of files
+	struct Tally {
+		unsigned functions = 0;
+		unsigned arguments = 0;
+		unsigned arrayArguments = 0;
+		unsigned wrongAnswers = 0;
+		unsigned wrongArrays = 0;
+		unsigned wrongDueToIIGlue = 0;
+		unsigned truePositives = 0;
+		unsigned falsePositives = 0;
+		unsigned falsePositiveArrays = 0;
+		unsigned falsePositivesDueToLength = 0;
+		unsigned falsePositivesDueToLengthArrays = 0;
+		unsigned varargs = 0;
+		unsigned falseNegativesPassedToVarargs = 0;
+		set<string> wronglyAnnotatedFunctions;
+		vector<string> falsePositiveList;
+		vector<string> falseNegativeList;
+	};
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  reading either output format: one object holding all functions
+//  under "library_functions", or one object per function with its
+//  name under "function"
+//
+
+typedef function<void(string name, FunctionRecord &)> Visit;
+
+
+static void readIntegers(JSONScanner &scanner, vector<int64_t> &values) {
+	scanner.enterArray();
+	while (scanner.nextElement())
+		values.push_back(scanner.readInteger());
+}
+
+
+static void readStrings(JSONScanner &scanner, vector<string> &values) {
+	scanner.enterArray();
+	while (scanner.nextElement())
+		values.push_back(scanner.readString());
+}
+
+
+// read one member of a function's record, if scoring needs it
+static bool readField(JSONScanner &scanner, StringRef key, FunctionRecord &record) {
+	if (key == "argument_annotations")
+		readIntegers(scanner, record.annotations);
+	else if (key == "args_array_receivers")
+		readIntegers(scanner, record.arrays);
+	else if (key == "argument_names")
+		readStrings(scanner, record.names);
+	else if (key == "argument_reasons")
+		readStrings(scanner, record.reasons);
+	else
+		return false;
+	return true;
+}
+
+
+static void scanResults(const string &filename, const Visit &visit) {
+	const MappedFile contents(filename);
+	JSONScanner scanner(contents.contents());
+
+	while (!scanner.atEnd()) {
+		string recordName;
+		FunctionRecord record;
+		bool isRecord = false;
+
+		scanner.enterObject();
+		StringRef key;
+		while (scanner.nextMember(key)) {
+			if (key == "library_functions") {
+				scanner.enterObject();
+				while (scanner.nextMember(key)) {
+					const string name = key.str();
+					FunctionRecord function;
+					scanner.enterObject();
+					while (scanner.nextMember(key))
+						if (!readField(scanner, key, function))
+							scanner.skipValue();
+					visit(name, function);
+				}
+			} else if (key == "function") {
+				recordName = scanner.readString();
+				isRecord = true;
+			} else if (!readField(scanner, key, record))
+				scanner.skipValue();
+		}
+
+		if (isRecord)
+			visit(std::move(recordName), record);
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+static string percent(double part, double whole) {
+	if (whole == 0)
+		return "n/a";
+	string text;
+	raw_string_ostream(text) << format("%.1f%%", 100. * part / whole);
+	return text;
+}
+
+
+static const string &field(const vector<string> &values, size_t index) {
+	static const string missing;
+	return index < values.size() ? values[index] : missing;
+}
+
+
+static void score(const string &name, const FunctionRecord &output, const FunctionRecord &answer, Tally &tally, raw_ostream &report) {
+	if (!answer.arrays.empty() && answer.arrays[0] == -1)
+		return;
+	if (answer.annotations.size() < output.annotations.size() || answer.arrays.size() < output.annotations.size()
+	    || output.arrays.size() < output.annotations.size())
+		throw runtime_error("argument counts differ for " + name);
+
+	for (size_t j = 0; j < output.annotations.size(); ++j) {
+		const int64_t expected = answer.annotations[j];
+		const int64_t found = output.annotations[j];
+		const int64_t answerArray = answer.arrays[j];
+
+		// skip anything that was a dependency, don't count it either way
+		if (answerArray == -1)
+			continue;
+		if (expected == 4 || answerArray == 4) {
+			++tally.varargs;
+			continue;
+		}
+		++tally.arguments;
+		if (answerArray == 1)
+			++tally.arrayArguments;
+		if (expected == found) {
+			if (expected == 2)
+				++tally.truePositives;
+			continue;
+		}
+
+		const auto mismatch = [&]() {
+			return name + '[' + to_string(j) + "] (" + field(output.names, j) + ") should be "
+				+ to_string(expected) + " found " + to_string(found);
+		};
+
+		if (expected == 2 || expected == 0) {
+			tally.wronglyAnnotatedFunctions.insert(name);
+			++tally.wrongAnswers;
+			if (answerArray == 1)
+				++tally.wrongArrays;
+			if (output.arrays[j] == 0)
+				++tally.wrongDueToIIGlue;
+			if (found == 2) {
+				report << mismatch() << " because " << field(output.reasons, j) << '\n';
+				++tally.falsePositives;
+				if (answerArray == 1)
+					++tally.falsePositiveArrays;
+				tally.falsePositiveList.push_back(mismatch());
+			} else if (found == 0)
+				tally.falseNegativeList.push_back(mismatch());
+		} else if (expected == 1 && found == 2)
+			throw runtime_error(mismatch() + ", which should not happen yet");
+		else if (expected == 3 && found != 0 && found != 3) {
+			tally.wronglyAnnotatedFunctions.insert(name);
+			if (answerArray == 1) {
+				++tally.wrongArrays;
+				++tally.falsePositiveArrays;
+			}
+			++tally.wrongAnswers;
+			++tally.falsePositives;
+			tally.falsePositiveList.push_back(mismatch());
+		} else if (expected == 5 && found != 0 && found != 5) {
+			tally.wronglyAnnotatedFunctions.insert(name);
+			if (answerArray == 1) {
+				++tally.wrongArrays;
+				++tally.falsePositiveArrays;
+				++tally.falsePositivesDueToLengthArrays;
+			}
+			++tally.wrongAnswers;
+			++tally.falsePositivesDueToLength;
+			++tally.falsePositives;
+			tally.falsePositiveList.push_back(mismatch());
+		} else if (expected == 6 && found != 6 && found != 2) {
+			tally.wronglyAnnotatedFunctions.insert(name);
+			if (answerArray == 1)
+				++tally.wrongArrays;
+			++tally.wrongAnswers;
+			++tally.falseNegativesPassedToVarargs;
+			tally.falseNegativeList.push_back(mismatch());
+		}
+	}
+}
+
+
+static void summarize(const Tally &tally, raw_ostream &report) {
+	report << "Total number of functions: " << tally.functions << '\n'
+	       << "Total number of arguments: " << tally.arguments << '\n'
+	       << "Total number of array arguments: " << tally.arrayArguments << '\n'
+	       << "Total number of wrongly annotated functions: " << tally.wronglyAnnotatedFunctions.size() << '\n'
+	       << "Total percentage of wrongly annotated functions: " << percent(tally.wronglyAnnotatedFunctions.size(), tally.functions) << '\n'
+	       << "Number of wrong answers: " << tally.wrongAnswers << '\n'
+	       << "Percent wrong answers total: " << percent(tally.wrongAnswers, tally.arguments) << '\n'
+	       << "Percent wrong answers in array arguments: " << percent(tally.wrongArrays, tally.arrayArguments) << '\n'
+	       << "Number of wrong answers due to IIGlue: " << tally.wrongDueToIIGlue << '\n';
+	if (tally.wrongAnswers)
+		report << "Percent wrong answers due to IIGlue of all errors: " << percent(tally.wrongDueToIIGlue, tally.wrongAnswers) << '\n';
+	report << "Number of false positives: " << tally.falsePositives << '\n'
+	       << "Number of true positives: " << tally.truePositives << '\n';
+	if (tally.falsePositives > 0)
+		report << "Percent false positives total: " << percent(tally.falsePositives, tally.arguments) << '\n'
+		       << "Percent false positives of array arguments: " << percent(tally.falsePositiveArrays, tally.arrayArguments) << '\n'
+		       << "Percent false positives of all errors: " << percent(tally.falsePositives, tally.wrongAnswers) << '\n'
+		       << "Number of false positives due to extra length parameter: " << tally.falsePositivesDueToLength << '\n'
+		       << "Percent false positives due to extra length parameter total: " << percent(tally.falsePositivesDueToLength, tally.arguments) << '\n'
+		       << "Percent false positives due to extra length parameter of array arguments: " << percent(tally.falsePositivesDueToLengthArrays, tally.arrayArguments) << '\n'
+		       << "Percent false positives due to extra length parameter of false positives: " << percent(tally.falsePositivesDueToLength, tally.falsePositives) << '\n';
+	report << "Number of functions with varargs found: " << tally.varargs << '\n'
+	       << "Percent of functions with varags found: " << percent(tally.varargs, tally.functions) << '\n'
+	       << "Number of false negatives passed to varargs: " << tally.falseNegativesPassedToVarargs << '\n';
+
+	if (listMismatches) {
+		const auto list = [&](const char heading[], const vector<string> &mismatches) {
+			report << heading;
+			for (const string &mismatch : mismatches)
+				report << (&mismatch == &mismatches.front() ? " " : "\n") << mismatch;
+			report << '\n';
+		};
+		list("False positives:", tally.falsePositiveList);
+		list("False negatives:", tally.falseNegativeList);
+	}
+}
+
+
+static void evaluate(const string &outputFileName, const string &answersFileName, raw_ostream &report) {
+	unordered_map<string, FunctionRecord> answers;
+	scanResults(answersFileName, [&](string name, FunctionRecord &record) {
+			answers[std::move(name)] = std::move(record);
+		});
+
+	// functions on either side only, which make the scores meaningless
+	Tally tally;
+	unordered_set<string> seen;
+	vector<string> onlyInOutput;
+	scanResults(outputFileName, [&](string name, FunctionRecord &record) {
+			if (!seen.insert(name).second)
+				return;
+			const auto answer = answers.find(name);
+			if (answer == answers.end())
+				onlyInOutput.push_back(std::move(name));
+			else if (onlyInOutput.empty())
+				score(name, record, answer->second, tally, report);
+		});
+	tally.functions = seen.size();
+
+	vector<string> onlyInAnswers;
+	for (const auto &answer : answers)
+		if (!seen.count(answer.first))
+			onlyInAnswers.push_back(answer.first);
+
+	if (!onlyInOutput.empty() || !onlyInAnswers.empty()) {
+		string message = "results and answers cover different functions";
+		for (const string &name : onlyInOutput)
+			message += "\noutput key not among answer keys: " + name;
+		for (const string &name : onlyInAnswers)
+			message += "\nanswer key not among output keys: " + name;
+		throw runtime_error(message);
+	}
+
+	summarize(tally, report);
+}
+
+
+int main(int argc, char *argv[]) {
+	cl::ParseCommandLineOptions(argc, argv, "score NullAnnotator results against expected answers\n");
+	if (fileNames.size() % 2) {
+		errs() << argv[0] << ": results and answers files must come in pairs\n";
+		return 1;
+	}
+
+	const size_t pairs = fileNames.size() / 2;
+	vector<string> reports(pairs), errors(pairs);
+	parallelFor(jobCount, pairs, [&](size_t pair) {
+			raw_string_ostream report(reports[pair]);
+			try {
+				evaluate(fileNames[2 * pair], fileNames[2 * pair + 1], report);
+			} catch (const exception &error) {
+				errors[pair] = error.what();
+			}
+		});
+
+	bool failed = false;
+	for (size_t pair = 0; pair < pairs; ++pair) {
+		if (pairs > 1)
+			outs() << (pair ? "\n" : "") << "== " << fileNames[2 * pair] << " vs. " << fileNames[2 * pair + 1] << " ==\n";
+		if (errors[pair].empty())
+			outs() << reports[pair];
+		else {
+			outs().flush();
+			errs() << argv[0] << ": " << fileNames[2 * pair] << ": " << errors[pair] << '\n';
+			failed = true;
+		}
+	}
+	return failed;
+}
@@ -1,18 +1,25 @@
 #define DEBUG_TYPE "find-sentinels" 
-#include "BacktrackPhiNodes.hh"
+#include "Counters.hh"
 #include "FindSentinels.hh"
+#include "FunctionAnalyses.hh"
 #include "IIGlueReader.hh"
+#include "Parallel.hh"
 #include "PatternMatch-extras.hh"
+#include "ReachingArguments.hh"
+#include "Trace.hh"
 
-#include <boost/container/flat_map.hpp>
+#include <algorithm>
 #include <boost/container/flat_set.hpp>
 #include <boost/range/adaptor/indirected.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/irange.hpp>
-#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Debug.h>
+#include <numeric>
 
 using namespace boost;
 using namespace boost::adaptors;
@@ -22,75 +29,337 @@ using namespace llvm::PatternMatch;
 using namespace std;
 
 
+static Counter functionsAnalyzed("find-sentinels", "functions");
+static Counter loopsExamined("find-sentinels", "loops");
+static Counter exitingBlocksExamined("find-sentinels", "exiting-blocks-examined");
+static Counter sentinelChecksFound("find-sentinels", "sentinel-checks");
+static Counter dominatorVerdicts("find-sentinels", "dominator-verdicts");
+static Counter loopWalks("find-sentinels", "loop-walks");
+static MemoryGauge resultsHeld("find-sentinels", "allSentinelChecks");
+
+
 ////////////////////////////////////////////////////////////////////////
 //
-//  collect the set of all arguments that may flow to a given value
-//  across zero or more phi nodes
+//  a loop's blocks numbered densely, header first, with edges leaving
+//  the loop dropped, plus one row of bits per block marking which of
+//  several arguments that block checks for a sentinel
+//
+//  Bit k of every row belongs to argument k, so one traversal of the
+//  loop answers the optionality question for all arguments at once.
 //
 
 namespace {
-	typedef std::unordered_set<const llvm::Argument *> ArgumentSet;
-
-	class ArgumentsReachingValue : public BacktrackPhiNodes {
+	class DenseLoop {
 	public:
-		void visit(const Argument &) final override;
-		ArgumentSet result;
+		DenseLoop(const Loop &, unsigned arguments);
+
+		// mark block as a sentinel check of the given argument
+		void close(const BasicBlock &, unsigned argument);
+
+		// For each argument, is there a nontrivial path from loop
+		// entry to loop entry without passing through any of that
+		// argument's sentinel checks?  Bit k of the result answers
+		// for argument k.
+		BitVector bypassable() const;
+
+	private:
+		typedef uint64_t Word;
+		static const unsigned wordBits = 64;
+		const unsigned arguments;
+		const unsigned words;
+
+		DenseMap<const BasicBlock *, unsigned> indexes;
+		// successors of block b are successors[firstSuccessor[b]]
+		// through successors[firstSuccessor[b + 1] - 1]
+		SmallVector<unsigned, 32> firstSuccessor;
+		SmallVector<unsigned, 64> successors;
+		// row of block b is closed[b * words] through closed[(b + 1) * words - 1]
+		SmallVector<Word, 32> closed;
 	};
 }
 
 
-void ArgumentsReachingValue::visit(const Argument &reached) {
-	result.insert(&reached);
+DenseLoop::DenseLoop(const Loop &loop, unsigned arguments)
+	: arguments(arguments),
+	  words((arguments + wordBits - 1) / wordBits) {
+	const std::vector<BasicBlock *> &blocks = loop.getBlocks();
+	assert(blocks.front() == loop.getHeader());
+	for (const BasicBlock * const block : blocks)
+		indexes.insert(make_pair(block, indexes.size()));
+
+	for (const BasicBlock * const block : blocks) {
+		firstSuccessor.push_back(successors.size());
+		for (auto succ = succ_begin(block), end = succ_end(block); succ != end; ++succ) {
+			const auto found = indexes.find(*succ);
+			if (found != indexes.end())
+				successors.push_back(found->second);
+		}
+	}
+	firstSuccessor.push_back(successors.size());
+	closed.resize(blocks.size() * words);
 }
 
 
-static ArgumentSet argumentsReachingValue(const Value &start) {
-	ArgumentsReachingValue explorer;
-	explorer.backtrack(start);
-	return std::move(explorer.result);
+void DenseLoop::close(const BasicBlock &block, unsigned argument) {
+	assert(indexes.count(&block));
+	assert(argument < arguments);
+	closed[indexes.lookup(&block) * words + argument / wordBits] |= Word(1) << argument % wordBits;
 }
 
 
-/**
- * This mutually-recursive group of functions check whether a given list of sentinel checks is
- * optional using a modified depth first search.  The basic question they attempt to answer is: "Is
- * there a nontrivial path from loop entry to loop entry without passing through a sentinel check?"
- *
- * Sentinel checks are pre-added to foundSoFar, current starts as loop entry, and the goal is loop
- * entry.
- **/
+BitVector DenseLoop::bypassable() const {
+	// live[b] has bit k set if block b is reachable from the loop
+	// header without passing through any sentinel check of argument k;
+	// every search starts at the header, so its own row is all ones,
+	// and paths that arrive back at it are collected separately
+	const unsigned header = 0;
+	const unsigned blocks = firstSuccessor.size() - 1;
+	SmallVector<Word, 32> live(blocks * words);
+	SmallVector<Word, 4> returned(words);
+	std::fill(live.begin(), live.begin() + words, ~Word(0));
+
+	BitVector queued(blocks);
+	SmallVector<unsigned, 32> worklist;
+	worklist.push_back(header);
+	queued.set(header);
+
+	// sweep to a fixed point: each row only ever gains bits
+	while (!worklist.empty()) {
+		const unsigned block = worklist.pop_back_val();
+		queued.reset(block);
+		const Word * const from = &live[block * words];
+
+		for (unsigned edge = firstSuccessor[block]; edge != firstSuccessor[block + 1]; ++edge) {
+			const unsigned succ = successors[edge];
+			const Word * const barrier = &closed[succ * words];
+
+			if (succ == header) {
+				for (unsigned word = 0; word < words; ++word)
+					returned[word] |= from[word] & ~barrier[word];
+				continue;
+			}
 
-static bool reachable(const Loop &, BlockSet &foundSoFar, const BasicBlock &current, const BasicBlock &goal);
+			Word * const to = &live[succ * words];
+			bool changed = false;
+			for (unsigned word = 0; word < words; ++word) {
+				const Word grown = to[word] | (from[word] & ~barrier[word]);
+				changed |= grown != to[word];
+				to[word] = grown;
+			}
+			if (changed && !queued.test(succ)) {
+				queued.set(succ);
+				worklist.push_back(succ);
+			}
+		}
+	}
 
-static bool reachableNontrivially(const Loop &loop, BlockSet &foundSoFar, const BasicBlock &current, const BasicBlock &goal) {
-	// look for reachable path across any one successor
-	return any_of(succ_begin(&current), succ_end(&current),
-			[&](const BasicBlock * const succ) { return reachable(loop, foundSoFar, *succ, goal); });
+	BitVector result(arguments);
+	for (unsigned argument = 0; argument < arguments; ++argument)
+		if (returned[argument / wordBits] >> argument % wordBits & 1)
+			result.set(argument);
+	return result;
 }
 
-static bool reachable(const Loop &loop, BlockSet &foundSoFar, const BasicBlock &current, const BasicBlock &goal) {
-	// mark as found so we don't revisit in the future
-	const bool novel = foundSoFar.insert(&current).second;
 
-	// already explored here, or is intentionally closed-off sentinel check
-	if (!novel) return false;
-	// trivially reached goal
-	if (&current == &goal) {
-		return true;
-	}
+// Does some one sentinel check lie on every path around the loop?  Each
+// trip around ends with a back edge from some latch, so a check that
+// dominates every latch cannot be bypassed.
+static bool dominatesLatches(FunctionAnalyses::Dominators &dominators, ArrayRef<const BasicBlock *> checks, ArrayRef<const BasicBlock *> latches) {
+	return std::any_of(checks.begin(), checks.end(), [&](const BasicBlock * const check) {
+			return std::all_of(latches.begin(), latches.end(), [&](const BasicBlock * const latch) {
+					return dominators.dominates(check, latch);
+				});
+		});
+}
 
-	// not allowed to leave this loop
-	if (!loop.contains(&current)) {
-		return false;
+
+// find sentinel checks in every loop of a single function, at any
+// depth; safe to run concurrently on distinct functions
+static unique_ptr<SentinelChecks> findSentinelChecks(const Function &func, const IIGlueReader &iiglue, ReachingArguments &reachingArguments, FunctionAnalyses::Dominators &dominators, const FunctionAnalyses::Loops &LI) {
+#if 0
+	// bail out early if func has no array arguments
+	// up for discussion - seems to lead to some unintuitive results that I want to discuss before readding.
+	if (!any_of(func.arg_begin(), func.arg_end(), [&](const Argument &arg) {
+				return iiglue.isArray(arg);
+			}))
+		return;
+#endif
+	std::vector<const Argument *> arrayArguments;
+	std::vector<unsigned> slots(func.arg_size());
+	for (const Argument &arg : iiglue.arrayArguments(func)) {
+		slots[arg.getArgNo()] = arrayArguments.size();
+		arrayArguments.push_back(&arg);
 	}
+	unique_ptr<SentinelChecks> results(new SentinelChecks(func, arrayArguments));
+	++functionsAnalyzed;
+
+	// We must look through all the loops, including nested ones, to determine if any of them contain a sentinel check.
+	SmallVector<const Loop *, 8> loops(LI.begin(), LI.end());
+	while (!loops.empty()) {
+		const Loop * const loop = loops.pop_back_val();
+		loops.append(loop->begin(), loop->end());
+		SmallVector<SentinelChecks::BlockList, 4> sentinelChecks(arrayArguments.size());
+		++loopsExamined;
+
+		TraceScope matching("match sentinel checks", func.getName());
+		SmallVector<BasicBlock *, 4> exitingBlocks;
+		loop->getExitingBlocks(exitingBlocks);
+		exitingBlocksExamined += exitingBlocks.size();
+		for (BasicBlock *exitingBlock : exitingBlocks) {
+			TerminatorInst * const terminator = exitingBlock->getTerminator();
+			// to be bound to pattern elements if match succeeds
+			BasicBlock *trueBlock, *falseBlock;
+			CmpInst::Predicate predicate;
+			// This will need to be checked to make sure it corresponds to an argument identified as an array.
+			Value *pointer;
+			Value *slot;
+
+			// reusable pattern fragments
+
+			auto loadPattern = m_Load(
+					m_GetElementPointer(
+							m_Value(pointer),
+							m_Value(slot)
+							)
+					);
+
+			auto compareZeroPattern = m_ICmp(predicate,
+					m_CombineOr(
+							loadPattern,
+							m_SExt(loadPattern)
+							),
+							m_Zero()
+					);
+
+			// Clang 3.4 without optimization, after running mem2reg:
+			//
+			//     %0 = getelementptr inbounds i8* %pointer, i64 %slot
+			//     %1 = load i8* %0, align 1
+			//     %element = sext i8 %1 to i32
+			//     %2 = icmp ne i32 %element, 0
+			//     br i1 %2, label %trueBlock, label %falseBlock
+			//
+			// Clang 3.4 with any level of optimization:
+			//
+			//     %0 = getelementptr inbounds i8* %pointer, i64 %slot
+			//     %1 = load i8* %0, align 1
+			//     %element = icmp eq i8 %1, 0
+			//     br i1 %element, label %trueBlock, label %falseBlock
+			// When optimized code has an OR:
+			//    %arrayidx = getelementptr inbounds i8* %pointer, i64 %slot
+			//    %0 = load i8* %arrayidx, align 1, !tbaa !0
+			//    %cmp = icmp eq i8 %0, %goal
+			//    %cmp6 = icmp eq i8 %0, 0
+			//    %or.cond = or i1 %cmp, %cmp6
+			//    %indvars.iv.next = add i64 %indvars.iv, 1
+			//    br i1 %or.cond, label %for.end, label %for.cond
+			if (match(terminator,
+					m_Br(
+						m_CombineOr(
+								compareZeroPattern,
+								m_CombineOr(
+									m_Or(
+										compareZeroPattern,
+										m_Value()
+										),
+									m_Or(
+										m_Value(),
+										compareZeroPattern
+										)
+								)
+						),
+						trueBlock,
+						falseBlock))) {
+				const SmallBitVector &reaching = reachingArguments(*pointer);
+				if (reaching.none()) continue;
+
+				// Two or more is possible,
+				// but we don't handle it yet.
+				assert(reaching.count() == 1);
+				const Argument &formalArg = *next(func.arg_begin(), reaching.find_first());
+
+				if (!iiglue.isArray(formalArg)) continue;
+
+				// check that we actually leave the loop when sentinel is found
+				const BasicBlock *sentinelDestination;
+				switch (predicate) {
+				case CmpInst::ICMP_EQ:
+					sentinelDestination = trueBlock;
+					break;
+				case CmpInst::ICMP_NE:
+					sentinelDestination = falseBlock;
+					break;
+				default:
+					continue;
+				}
+				if (loop->contains(sentinelDestination)) {
+					DEBUG(dbgs() << "dest still in loop!\n");
+					continue;
+				}
+				// all tests pass; this is a possible sentinel check!
+				DEBUG(dbgs() << "found possible sentinel check of %" << formalArg.getName() << "[%" << slot->getName() << "]\n"
+				      << "  exits loop by jumping to %" << sentinelDestination->getName() << '\n');
+				// mark this block as one of the sentinel checks this loop.
+				sentinelChecks[slots[formalArg.getArgNo()]].push_back(exitingBlock);
+				++sentinelChecksFound;
+				auto induction(loop->getCanonicalInductionVariable());
+				if (induction)
+					DEBUG(dbgs() << "  loop has canonical induction variable %" << induction->getName() << '\n');
+				else
+					DEBUG(dbgs() << "  loop has no canonical induction variable\n");
+			}
+			}
+			matching.close();
+			BitVector optional(arrayArguments.size());
+			const auto decide = [&](unsigned index, bool bypassable) {
+				if (bypassable) {
+					DEBUG(dbgs() << "The sentinel check was optional!\n");
+					optional.set(index);
+				}
+				else {
+					DEBUG(dbgs() << "The sentinel check was non-optional - hooray!\n");
+					optional.reset(index);
+				}
+			};
+
+			SmallVector<const BasicBlock *, 4> latches;
+			const BasicBlock * const header = loop->getHeader();
+			for (auto pred = pred_begin(header), end = pred_end(header); pred != end; ++pred)
+				if (loop->contains(*pred))
+					latches.push_back(*pred);
+
+			// settle easy cases with the shared dominator tree, and
+			// leave only the rest for a walk over the loop body
+			SmallVector<unsigned, 8> undecided;
+			for (const unsigned index : irange<unsigned>(0, arrayArguments.size())) {
+				const SentinelChecks::BlockList &checks = sentinelChecks[index];
+				if (checks.empty())
+					decide(index, true);
+				else if (dominatesLatches(dominators, checks, latches)) {
+					decide(index, false);
+					++dominatorVerdicts;
+				}
+				else
+					undecided.push_back(index);
+			}
 
-	// not trivially done, so look for nontrivial path
-	return reachableNontrivially(loop, foundSoFar, current, goal);
-}
+			// one traversal decides every remaining argument of this loop
+			if (!undecided.empty()) {
+				const TraceScope tracing("sentinel optionality walk", func.getName());
+				++loopWalks;
+				DenseLoop denseLoop(*loop, undecided.size());
+				for (const unsigned bit : irange<unsigned>(0, undecided.size()))
+					for (const BasicBlock * const check : sentinelChecks[undecided[bit]])
+						denseLoop.close(*check, bit);
+				const BitVector bypassable = denseLoop.bypassable();
+				for (const unsigned bit : irange<unsigned>(0, undecided.size()))
+					decide(undecided[bit], bypassable.test(bit));
+			}
+
+			results->addLoop(*header, sentinelChecks, optional);
+		}
 
-static bool DFSCheckSentinelOptional(const Loop &loop, BlockSet &foundSoFar) {
-	const BasicBlock &loopEntry = *loop.getHeader();
-	return reachableNontrivially(loop, foundSoFar, loopEntry, loopEntry);
+	return results;
 }
 
 
@@ -100,177 +369,89 @@ static const RegisterPass<FindSentinels> registration("find-sentinels",
 
 char FindSentinels::ID;
 
+static cl::opt<unsigned>
+	threadCount("find-sentinels-threads",
+		cl::init(1),
+		cl::value_desc("count"),
+		cl::desc("Number of threads used to find sentinel checks in independent functions"));
+
+static cl::opt<bool>
+	eager("find-sentinels-eager",
+		cl::desc("Find sentinel checks in every function up front rather than on demand, e.g. to time this pass on its own"));
+
 
 inline FindSentinels::FindSentinels()
-	: ModulePass(ID) {
+	: ModulePass(ID),
+	  resultBytes(0),
+	  iiglue(nullptr),
+	  reachingArguments(nullptr),
+	  functionAnalyses(nullptr) {
 }
 
 void FindSentinels::getAnalysisUsage(AnalysisUsage &usage) const {
 	// read-only pass never changes anything
 	usage.setPreservesAll();
-	usage.addRequired<LoopInfo>();
-	usage.addRequired<IIGlueReader>();
+	// results are computed lazily, so these must outlive this pass
+	usage.addRequiredTransitive<FunctionAnalyses>();
+	usage.addRequiredTransitive<IIGlueReader>();
+	usage.addRequiredTransitive<ReachingArguments>();
 }
 
 
 bool FindSentinels::runOnModule(Module &module) {
-	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
-	for (Function &func : module) {
+	iiglue = &getAnalysis<IIGlueReader>();
+	reachingArguments = &getAnalysis<ReachingArguments>();
+	functionAnalyses = &getAnalysis<FunctionAnalyses>();
+
+	// make room for every function's results up front, so concurrent
+	// lookups only ever fill in entries that already exist
+	std::vector<const Function *> functions;
+	for (const Function &func : module) {
 		if ((func.isDeclaration())) continue;
-		const LoopInfo &LI = getAnalysis<LoopInfo>(func);
-		unordered_map<const BasicBlock *, ArgumentToBlockSet> &functionSentinelChecks = allSentinelChecks[&func];
-#if 0
-		// bail out early if func has no array arguments
-		// up for discussion - seems to lead to some unintuitive results that I want to discuss before readding.
-		if (!any_of(func.arg_begin(), func.arg_end(), [&](const Argument &arg) {
-					return iiglue.isArray(arg);
-				}))
-			return false;
-#endif
-		// We must look through all the loops to determine if any of them contain a sentinel check.
-		for (const Loop * const loop : LI) {
-			ArgumentToBlockSet &sentinelChecks = functionSentinelChecks[loop->getHeader()];
-
-			SmallVector<BasicBlock *, 4> exitingBlocks;
-			loop->getExitingBlocks(exitingBlocks);
-			for (BasicBlock *exitingBlock : exitingBlocks) {
-				TerminatorInst * const terminator = exitingBlock->getTerminator();
-				// to be bound to pattern elements if match succeeds
-				BasicBlock *trueBlock, *falseBlock;
-				CmpInst::Predicate predicate;
-				// This will need to be checked to make sure it corresponds to an argument identified as an array.
-				Value *pointer;
-				Value *slot;
-
-				// reusable pattern fragments
-
-				auto loadPattern = m_Load(
-						m_GetElementPointer(
-								m_Value(pointer),
-								m_Value(slot)
-								)
-						);
-
-				auto compareZeroPattern = m_ICmp(predicate,
-						m_CombineOr(
-								loadPattern,
-								m_SExt(loadPattern)
-								),
-								m_Zero()
-						);
-
-				// Clang 3.4 without optimization, after running mem2reg:
-				//
-				//     %0 = getelementptr inbounds i8* %pointer, i64 %slot
-				//     %1 = load i8* %0, align 1
-				//     %element = sext i8 %1 to i32
-				//     %2 = icmp ne i32 %element, 0
-				//     br i1 %2, label %trueBlock, label %falseBlock
-				//
-				// Clang 3.4 with any level of optimization:
-				//
-				//     %0 = getelementptr inbounds i8* %pointer, i64 %slot
-				//     %1 = load i8* %0, align 1
-				//     %element = icmp eq i8 %1, 0
-				//     br i1 %element, label %trueBlock, label %falseBlock
-				// When optimized code has an OR:
-				//    %arrayidx = getelementptr inbounds i8* %pointer, i64 %slot
-				//    %0 = load i8* %arrayidx, align 1, !tbaa !0
-				//    %cmp = icmp eq i8 %0, %goal
-				//    %cmp6 = icmp eq i8 %0, 0
-				//    %or.cond = or i1 %cmp, %cmp6
-				//    %indvars.iv.next = add i64 %indvars.iv, 1
-				//    br i1 %or.cond, label %for.end, label %for.cond
-				if (match(terminator,
-						m_Br(
-							m_CombineOr(
-									compareZeroPattern,
-									m_CombineOr(
-										m_Or(
-											compareZeroPattern,
-											m_Value()
-											),
-										m_Or(
-											m_Value(),
-											compareZeroPattern
-											)
-									)
-							),
-							trueBlock,
-							falseBlock))) {
-					const ArgumentSet reaching = argumentsReachingValue(*pointer);
-					if (reaching.empty()) continue;
-
-					// Two or more is possible,
-					// but we don't handle it yet.
-					assert(reaching.size() == 1);
-					const Argument &formalArg = **reaching.begin();
-
-					if (!iiglue.isArray(formalArg)) continue;
-
-					// check that we actually leave the loop when sentinel is found
-					const BasicBlock *sentinelDestination;
-					switch (predicate) {
-					case CmpInst::ICMP_EQ:
-						sentinelDestination = trueBlock;
-						break;
-					case CmpInst::ICMP_NE:
-						sentinelDestination = falseBlock;
-						break;
-					default:
-						continue;
-					}
-					if (loop->contains(sentinelDestination)) {
-						DEBUG(dbgs() << "dest still in loop!\n");
-						continue;
-					}
-					// all tests pass; this is a possible sentinel check!
-					DEBUG(dbgs() << "found possible sentinel check of %" << formalArg.getName() << "[%" << slot->getName() << "]\n"
-					      << "  exits loop by jumping to %" << sentinelDestination->getName() << '\n');
-					// mark this block as one of the sentinel checks this loop.
-					sentinelChecks[&formalArg].first.insert(exitingBlock);
-					auto induction(loop->getCanonicalInductionVariable());
-					if (induction)
-						DEBUG(dbgs() << "  loop has canonical induction variable %" << induction->getName() << '\n');
-					else
-						DEBUG(dbgs() << "  loop has no canonical induction variable\n");
-				}
-				}
-				if (sentinelChecks.empty()) {
-					for (const Argument &arg : iiglue.arrayArguments(func)) {
-						sentinelChecks[&arg].second = true;
-					}
-					continue;
-				}
-				for (const Argument &arg : iiglue.arrayArguments(func)) {
-					pair<BlockSet, bool> &checks = sentinelChecks[&arg];
-					BlockSet foundSoFar = checks.first;
-					checks.second = true;
-					bool optional = DFSCheckSentinelOptional(*loop, foundSoFar);
-					if (optional) {
-						DEBUG(dbgs() << "The sentinel check was optional!\n");
-						checks.second = true;
-					}
-					else {
-						DEBUG(dbgs() << "The sentinel check was non-optional - hooray!\n");
-						checks.second = false;
-					}
-				}
-			}
+		allSentinelChecks[&func];
+		functions.push_back(&func);
 	}
+	resultBytes += heapBytes(allSentinelChecks);
+	resultsHeld.observe(resultBytes);
+
+	// results are normally computed lazily, for just those functions
+	// clients ask about; given several threads, compute them all now
+	if (threadCount > 1 || eager)
+		parallelFor(threadCount, functions.size(), [&](size_t index) {
+				getResultsForFunction(functions[index]);
+			});
+
 	// read-only pass never changes anything
 	return false;
 }
 
-/**
- * Compare two BasicBlock*'s using their names.
- **/
-class BasicBlockCompare { // simple comparison function
-public:
-	bool operator()(const BasicBlock *x, const BasicBlock *y) const {
-		return x->getName() < y->getName();
+
+const FindSentinels::FunctionResults *FindSentinels::getResultsForFunction(const Function *func) const {
+	const auto found = allSentinelChecks.find(func);
+	if (found == allSentinelChecks.end()) return nullptr;
+
+	const CachedResults &cached = found->second;
+	std::call_once(cached.computed, [&]() {
+			FunctionAnalyses::Dominators &dominators = functionAnalyses->dominators(*func);
+			const FunctionAnalyses::Loops &loops = functionAnalyses->loops(*func);
+			const TraceScope tracing("find sentinel checks", func->getName());
+			cached.results = findSentinelChecks(*func, *iiglue, *reachingArguments, dominators, loops);
+			resultsHeld.observe(resultBytes += sizeof(FunctionResults) + cached.results->memoryFootprint());
+		});
+	return cached.results.get();
+}
+
+
+size_t FindSentinels::memoryFootprint() const {
+	size_t total = 0;
+	for (const auto &entry : allSentinelChecks) {
+		total += sizeof(entry);
+		if (entry.second.results)
+			total += sizeof(FunctionResults) + entry.second.results->memoryFootprint();
 	}
-};
+	return total;
+}
+
 
 /**
  * Print helper method. The output looks like the following:
@@ -284,37 +465,39 @@ public:
  * For each sentinel check, the name of its basic block is printed.
  **/
 void FindSentinels::print(raw_ostream &sink, const Module *module) const {
-	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
 	for (const Function &func : *module) {
 		// print function name, how many loops found if any
 		sink << "Analyzing function: " << func.getName() << '\n';
-		if (allSentinelChecks.count(&func) == 0) {
+		const FunctionResults * const results = getResultsForFunction(&func);
+		if (!results) {
 			sink << "\tDetected no sentinel checks\n";
 			return;
 		}
-		const FunctionResults &unorderedChecks = allSentinelChecks.at(&func);
-		sink << "\tWe found: " << unorderedChecks.size() << " loops\n";
+		sink << "\tWe found: " << results->loopCount() << " loops\n";
 
 		// For each loop, print all sentinel checks and whether it is possible to go from loop entry to loop entry without
-		// passing a sentinel check.
-		const flat_map<const BasicBlock *, ArgumentToBlockSet, BasicBlockCompare> orderedChecks(unorderedChecks.begin(), unorderedChecks.end());
-		for (const auto &check : orderedChecks) {
-			const BasicBlock &header = *check.first;
-			const ArgumentToBlockSet &entry = check.second;
-			for (const Argument &arg : iiglue.arrayArguments(func)) {
-				const pair<BlockSet, bool> &checks = entry.at(&arg);
-				if (checks.first.empty()) continue;
+		// passing a sentinel check.  Loops are ordered by header name.
+		std::vector<unsigned> orderedLoops(results->loopCount());
+		std::iota(orderedLoops.begin(), orderedLoops.end(), 0);
+		std::sort(orderedLoops.begin(), orderedLoops.end(), [&](unsigned x, unsigned y) {
+				return results->header(x).getName() < results->header(y).getName();
+			});
+		for (const unsigned loop : orderedLoops) {
+			const BasicBlock &header = results->header(loop);
+			for (const Argument &arg : iiglue->arrayArguments(func)) {
+				const SentinelChecks::Blocks checks = results->checks(loop, arg);
+				if (checks.empty()) continue;
 				sink << "\tExamining " << arg.getName() << " in loop " << header.getName() << '\n';
-				sink << "\t\tThere are " << checks.first.size() << " sentinel checks of this argument in this loop\n";
-				sink << "\t\t\tWe can" << (checks.second ? "" : "not") << " bypass all sentinel checks for this argument in this loop.\n";
+				sink << "\t\tThere are " << checks.size() << " sentinel checks of this argument in this loop\n";
+				sink << "\t\t\tWe can" << (results->optional(loop, arg) ? "" : "not") << " bypass all sentinel checks for this argument in this loop.\n";
 				const auto names =
-						checks.first
+						checks
 						| indirected
 						| transformed([](const BasicBlock &block) {
 							return block.getName().str();
 						});
 				// print in sorted order for consistent output
-				flat_set<string> ordered(names.begin(), names.end());
+				flat_set<std::string> ordered(names.begin(), names.end());
 				sink << "\t\tSentinel checks: \n";
 				for (const auto &sentinelCheck : ordered)
 					sink << "\t\t\t" << sentinelCheck << '\n';
@@ -1,18 +1,19 @@
 #ifndef INCLUDE_FIND_SENTINELS_HH
 #define INCLUDE_FIND_SENTINELS_HH
 
+#include "SentinelChecks.hh"
+
 #include <llvm/Pass.h>
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
-#include <unordered_set>
-
-namespace llvm {
-	class Argument;
-}
 
-
-typedef std::unordered_set<const llvm::BasicBlock *> BlockSet;
-typedef std::unordered_map<const llvm::Argument *, std::pair<BlockSet, bool>> ArgumentToBlockSet;
+class FunctionAnalyses;
+class IIGlueReader;
+class ReachingArguments;
 
 
 class FindSentinels : public llvm::ModulePass {
@@ -24,22 +25,32 @@ public:
 	bool runOnModule(llvm::Module &) final override;
 	void print(llvm::raw_ostream &, const llvm::Module *) const final override;
 
-	// access to analysis results derived by this pass
-	typedef std::unordered_map<const llvm::BasicBlock *, ArgumentToBlockSet> FunctionResults;
+	// access to analysis results derived by this pass; each
+	// function's results are computed when first requested, and
+	// concurrent requests for the same function wait for one another
+	typedef SentinelChecks FunctionResults;
 	const FunctionResults *getResultsForFunction(const llvm::Function *) const;
 
-private:
-	std::unordered_map<const llvm::Function *, FunctionResults> allSentinelChecks;
-};
+	// heap memory held by results computed so far; call only while no
+	// lookups are in progress
+	size_t memoryFootprint() const;
 
+private:
+	struct CachedResults {
+		mutable std::once_flag computed;
+		mutable std::unique_ptr<FunctionResults> results;
+	};
 
-////////////////////////////////////////////////////////////////////////
+	// one entry per defined function, created before any lookups
+	std::unordered_map<const llvm::Function *, CachedResults> allSentinelChecks;
 
+	// heap bytes held by this instance's results, for the memory gauge
+	mutable std::atomic<uint64_t> resultBytes;
 
-inline const FindSentinels::FunctionResults *FindSentinels::getResultsForFunction(const llvm::Function *func) const {
-	const auto found = allSentinelChecks.find(func);
-	return found == allSentinelChecks.end() ? nullptr : &found->second;
-}
+	const IIGlueReader *iiglue;
+	ReachingArguments *reachingArguments;
+	FunctionAnalyses *functionAnalyses;
+};
 
 
 #endif // !INCLUDE_FIND_SENTINELS_HH
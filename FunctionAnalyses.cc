@@ -0,0 +1,77 @@
+#include "Counters.hh"
+#include "FunctionAnalyses.hh"
+#include "Trace.hh"
+
+#include <llvm/IR/Function.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static Counter dominatorTrees("function-analyses", "dominator-trees");
+static Counter loopForests("function-analyses", "loop-forests");
+
+
+static const RegisterPass<FunctionAnalyses> registration("function-analyses",
+		"Compute dominator trees and loops of functions on demand",
+		true, true);
+
+char FunctionAnalyses::ID;
+
+
+FunctionAnalyses::FunctionAnalyses()
+	: ModulePass(ID) {
+}
+
+
+void FunctionAnalyses::getAnalysisUsage(AnalysisUsage &usage) const {
+	// read-only pass never changes anything
+	usage.setPreservesAll();
+}
+
+
+bool FunctionAnalyses::runOnModule(Module &) {
+	// all work happens lazily, as clients ask about specific functions
+	return false;
+}
+
+
+void FunctionAnalyses::releaseMemory() {
+	entries.clear();
+}
+
+
+FunctionAnalyses::Entry &FunctionAnalyses::entry(const Function &function) {
+	// references to elements survive rehashing, so only finding or
+	// creating the entry needs the lock
+	const lock_guard<mutex> lock(entriesLock);
+	return entries[&function];
+}
+
+
+FunctionAnalyses::Dominators &FunctionAnalyses::dominators(const Function &function) {
+	Entry &cached = entry(function);
+	call_once(cached.dominatorsComputed, [&]() {
+			const TraceScope tracing("dominator tree", function.getName());
+			// construction only reads the function, but the graph
+			// traits it relies on are written for non-const blocks
+			cached.dominators.reset(new Dominators(false));
+			cached.dominators->recalculate(const_cast<Function &>(function));
+			cached.dominators->updateDFSNumbers();
+			++dominatorTrees;
+		});
+	return *cached.dominators;
+}
+
+
+const FunctionAnalyses::Loops &FunctionAnalyses::loops(const Function &function) {
+	Entry &cached = entry(function);
+	call_once(cached.loopsComputed, [&]() {
+			Dominators &tree = dominators(function);
+			const TraceScope tracing("loop info", function.getName());
+			cached.loops.reset(new Loops);
+			cached.loops->Analyze(tree);
+			++loopForests;
+		});
+	return *cached.loops;
+}
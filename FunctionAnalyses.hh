@@ -0,0 +1,61 @@
+#ifndef INCLUDE_FUNCTION_ANALYSES_HH
+#define INCLUDE_FUNCTION_ANALYSES_HH
+
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Pass.h>
+
+#if LLVM_VERSION_MAJOR > 3 || (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR > 4)
+#  include <llvm/IR/Dominators.h>
+#else // LLVM 3.4 or earlier
+#  include <llvm/Analysis/Dominators.h>
+#endif // LLVM 3.4 or earlier
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  per-function dominator trees and loop forests, computed only for
+//  functions that some client actually asks about, then cached and
+//  shared by every pass in the pipeline that requires this one
+//
+//  Safe to query from several threads at once, even for the same
+//  function.
+//
+
+class FunctionAnalyses : public llvm::ModulePass {
+public:
+	typedef llvm::DominatorTreeBase<llvm::BasicBlock> Dominators;
+	typedef llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> Loops;
+
+	// standard LLVM pass interface
+	FunctionAnalyses();
+	static char ID;
+	void getAnalysisUsage(llvm::AnalysisUsage &) const final override;
+	bool runOnModule(llvm::Module &) final override;
+	void releaseMemory() final override;
+
+	// cached analyses of a defined function; dominator trees come
+	// with depth-first numbers already assigned, so dominance queries
+	// never update them and may run concurrently
+	Dominators &dominators(const llvm::Function &);
+	const Loops &loops(const llvm::Function &);
+
+private:
+	struct Entry {
+		std::once_flag dominatorsComputed;
+		std::unique_ptr<Dominators> dominators;
+		std::once_flag loopsComputed;
+		std::unique_ptr<Loops> loops;
+	};
+
+	std::unordered_map<const llvm::Function *, Entry> entries;
+	std::mutex entriesLock;
+	Entry &entry(const llvm::Function &);
+};
+
+
+#endif // !INCLUDE_FUNCTION_ANALYSES_HH
@@ -1,17 +1,19 @@
+#include "Counters.hh"
 #include "IIGlueReader.hh"
+#include "JSONScanner.hh"
+#include "MappedFile.hh"
+#include "Trace.hh"
 
 #include <boost/container/flat_set.hpp>
-#include <boost/property_tree/json_parser.hpp>
 #include <boost/range/adaptor/indirected.hpp>
-#include <boost/range/adaptor/map.hpp>
-#include <boost/range/algorithm/find.hpp>
-#include <boost/range/combine.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <chrono>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
 
 using namespace boost::adaptors;
-using namespace boost::property_tree;
 using namespace llvm;
 using namespace std;
 
@@ -30,6 +32,14 @@ namespace {
 			cl::value_desc("filename"),
 			cl::desc("Filename containing iiglue analysis results; use multiple times to read multiple files"));
 	static cl::opt<bool> Overreport ("overreport", cl::desc("Overreport iiglue output; report everything as an array."));
+	static cl::opt<bool>
+	reportThroughput("iiglue-report-throughput",
+			 cl::desc("Report how quickly each iiglue results file was read"));
+
+	static Counter bytesRead("iiglue-reader", "bytes-read");
+	static Counter functionsRead("iiglue-reader", "library-functions");
+	static Counter arraysFound("iiglue-reader", "array-arguments");
+	static MemoryGauge arraysHeld("iiglue-reader", "arrays");
 }
 
 
@@ -40,12 +50,19 @@ void IIGlueReader::getAnalysisUsage(AnalysisUsage &usage) const {
 
 
 IIGlueReader::IIGlueReader()
-	: ModulePass(ID) {
-	if (!Overreport && iiglueFileNames.empty())
+	: IIGlueReader(vector<string>(iiglueFileNames.begin(), iiglueFileNames.end())) {
+}
+
+
+IIGlueReader::IIGlueReader(vector<string> fileNames)
+	: ModulePass(ID),
+	  fileNames(std::move(fileNames)),
+	  loaded(false) {
+	if (!Overreport && this->fileNames.empty())
 		errs() << "warning: neither \"-" << Overreport.ArgStr
 		       << "\" nor any \"-" << iiglueFileNames.ArgStr
 		       << "\" used on command line\n";
-	else if (Overreport && !iiglueFileNames.empty())
+	else if (Overreport && !this->fileNames.empty())
 		errs() << "warning: both \"-" << Overreport.ArgStr
 		       << "\" and \"-" << iiglueFileNames.ArgStr
 		       << "\" used on command line\n";
@@ -53,74 +70,131 @@ IIGlueReader::IIGlueReader()
 
 
 bool IIGlueReader::runOnModule(Module &module) {
-	// iterate over iiglue files we've been asked to read
+	if (!loaded)
+		read(module);
+
+	// we never change anything; we just stash information in private
+	// fields of this pass instance for later use
+	return false;
+}
+
+
+void IIGlueReader::read(const Module &module) {
+	loaded = true;
 	if (Overreport) {
-		for (Function &func : module) {
+		for (const Function &func : module) {
 			atLeastOneArrayArg.insert(&func);
-			for (Argument &arg : func.getArgumentList()) {
+			for (const Argument &arg : func.getArgumentList()) {
 				arrays.insert(&arg);
+				++arraysFound;
 			} 
 		}
-		return false;
+		arraysHeld.observe(heapBytes(arrays) + heapBytes(atLeastOneArrayArg));
+		return;
 	}
-	for (const string &iiglueFileName : iiglueFileNames) {
 
-		// read entire JSON-formatted iiglue output as property tree
-		ptree root;
-		json_parser::read_json(iiglueFileName, root);
+	// iterate over iiglue files we've been asked to read
+	for (const string &iiglueFileName : fileNames)
+		readFile(iiglueFileName, module);
+	arraysHeld.observe(heapBytes(arrays) + heapBytes(atLeastOneArrayArg));
+}
+
+
+void IIGlueReader::readFile(const string &iiglueFileName, const Module &module) {
+	const auto started = chrono::steady_clock::now();
+	const TraceScope tracing("read iiglue results", iiglueFileName);
+
+	// scan JSON-formatted iiglue output in place, without building a tree
+	const MappedFile contents(iiglueFileName);
+	JSONScanner scanner(contents.contents());
+	bytesRead += contents.size();
+
+	scanner.enterObject();
+	StringRef key;
+	while (scanner.nextMember(key)) {
+		if (key != "libraryFunctions") {
+			scanner.skipValue();
+			continue;
+		}
 
 		// iterate over iiglue-recognized library functions
-		const ptree &libraryFunctions = root.get_child("libraryFunctions");
-		for (const auto &functionInfo : libraryFunctions | map_values) {
+		scanner.enterContainer();
+		while (scanner.nextValue()) {
+			StringRef name;
+			bool named = false;
+			SmallVector<bool, 8> parameterIsArray;
+
+			scanner.enterObject();
+			while (scanner.nextMember(key)) {
+				if (key == "foreignFunctionName") {
+					name = scanner.readRawString();
+					named = true;
+				}
+
+				else if (key == "foreignFunctionParameters") {
+					scanner.enterContainer();
+					while (scanner.nextValue()) {
+						// PAArray annotation means iiglue thinks this is an array;
+						// ignore inferred array dimensionality: not needed yet
+						bool isArray = false;
+						scanner.enterObject();
+						while (scanner.nextMember(key)) {
+							if (key != "parameterAnnotations") {
+								scanner.skipValue();
+								continue;
+							}
+							scanner.enterContainer();
+							while (scanner.nextValue()) {
+								// each annotation is an object with a single tag
+								scanner.enterObject();
+								while (scanner.nextMember(key)) {
+									isArray |= key == "PAArray";
+									scanner.skipValue();
+								}
+							}
+						}
+						parameterIsArray.push_back(isArray);
+					}
+				}
+
+				else
+					scanner.skipValue();
+			}
+
+			if (!named)
+				throw JSONScanner::Error("library function without foreignFunctionName in " + iiglueFileName, scanner.offset());
+			++functionsRead;
+
 			// find corresponding LLVM function object
-			const string name = functionInfo.get<string>("foreignFunctionName");
 			const Function * const function = module.getFunction(name);
 			if (!function) {
 				errs() << "warning: found function " << name << " in iiglue results but not in bitcode\n";
 				continue;
 			}
 
-			// focus on function parameters, and check for arity mismatch
-			const ptree &foreignFunctionParameters = functionInfo.get_child("foreignFunctionParameters");
+			// check for arity mismatch
 			const Function::ArgumentListType &args = function->getArgumentList();
-			if (foreignFunctionParameters.size() != args.size()) {
-				errs() << "warning: function " << name << " has " << foreignFunctionParameters.size() << " arguments in iiglue results but " << args.size() << " arguments in bitcode\n";
+			if (parameterIsArray.size() != args.size()) {
+				errs() << "warning: function " << name << " has " << parameterIsArray.size() << " arguments in iiglue results but " << args.size() << " arguments in bitcode\n";
 				continue;
 			}
 
-			// iterate across each parameter and corresponding annotations
-			const auto parameterAnnotations =
-				foreignFunctionParameters
-				| map_values
-				| transformed([](const ptree &pt) {
-						return pt.get_child("parameterAnnotations");
-					})
-				;
-			for (const auto &slot : boost::combine(parameterAnnotations, args)) {
-				// extract just the names (tags) of each annotation
-				const auto annotationTags =
-					slot.get<0>()
-					| map_values
-					| transformed([](const ptree &pt) {
-							assert(pt.size() == 1);
-							return pt.front();
-						})
-					| map_keys
-					;
-
-				// PAArray annotation means iiglue thinks this is an array;
-				// ignore inferred array dimensionality: not needed yet
-				if (find(annotationTags, "PAArray") != end(annotationTags)) {
-					arrays.insert(&slot.get<1>());
+			auto isArray = parameterIsArray.begin();
+			for (const Argument &arg : args)
+				if (*isArray++) {
+					if (arrays.insert(&arg).second)
+						++arraysFound;
 					atLeastOneArrayArg.insert(function);
 				}
-			}
 		}
 	}
-	
-	// we never change anything; we just stash information in private
-	// fields of this pass instance for later use
-	return false;
+
+	if (reportThroughput) {
+		const chrono::duration<double> elapsed = chrono::steady_clock::now() - started;
+		const double megabytes = contents.size() / 1e6;
+		errs() << "read " << megabytes << " MB of iiglue results from " << iiglueFileName
+		       << " in " << elapsed.count() << " s (" << megabytes / elapsed.count() << " MB/s)\n";
+	}
 }
 
 
@@ -5,7 +5,9 @@
 #include <boost/range/adaptor/indirected.hpp>
 #include <llvm/IR/Function.h>
 #include <llvm/Pass.h>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace llvm {
 	class Argument;
@@ -37,6 +39,13 @@ private:
 	typedef std::unordered_set<const llvm::Function *> FunctionSet;
 	FunctionSet atLeastOneArrayArg;
 
+	// iiglue results files to read, and whether they have been
+	const std::vector<std::string> fileNames;
+	bool loaded;
+
+	// stream one iiglue results file, binding array tags to arguments
+	void readFile(const std::string &, const llvm::Module &);
+
 public:
 	// standard LLVM pass interface
 	IIGlueReader();
@@ -45,10 +54,19 @@ public:
 	bool runOnModule(llvm::Module &) final override;
 	void print(llvm::raw_ostream &, const llvm::Module *) const final override;
 
+	// read these files instead of those named with "-iiglue-read-file"
+	explicit IIGlueReader(std::vector<std::string> fileNames);
+
+	// read results for this module now rather than when the pass runs,
+	// so that drivers catch unreadable or malformed files before
+	// running any passes; LLVM is not built to unwind exceptions
+	void read(const llvm::Module &);
+
 	// convenience methods to access loaded iiglue annotations
 	typedef boost::filtered_range<IsArray, const llvm::Function::ArgumentListType> ArrayArgumentsRange;
 	typedef boost::indirected_range<const FunctionSet> ArrayReceiversRange;
 	bool isArray(const llvm::Argument &) const;
+	bool isArrayReceiver(const llvm::Function &) const;
 	ArrayArgumentsRange arrayArguments(const llvm::Function &function) const;
 	ArrayReceiversRange arrayReceivers() const;
 };
@@ -72,6 +90,11 @@ inline bool IIGlueReader::isArray(const llvm::Argument &argument) const {
 }
 
 
+inline bool IIGlueReader::isArrayReceiver(const llvm::Function &function) const {
+	return atLeastOneArrayArg.count(&function) != 0;
+}
+
+
 inline IIGlueReader::ArrayArgumentsRange IIGlueReader::arrayArguments(const llvm::Function &function) const {
 	return { IsArray(*this), function.getArgumentList() };
 }
@@ -0,0 +1,138 @@
+#include "IncrementalCache.hh"
+#include "MappedFile.hh"
+#include "OutputFile.hh"
+
+#include <cerrno>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/raw_ostream.h>
+#include <stdexcept>
+#include <system_error>
+
+using namespace llvm;
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  file layout is line-oriented text: a signature line, then for each
+//  component a "component <key> <members>" line followed by one line
+//  per member holding tab-separated name, answer digits, reason digits,
+//  and one source name per argument
+//
+//  Function and block names never contain tabs or newlines.
+//
+
+static const StringRef signature = "CArrayIntrospection incremental cache 2";
+
+
+IncrementalCache::IncrementalCache(const string &filename)
+	: filename(filename) {
+	unique_ptr<MappedFile> mapping;
+	try {
+		mapping.reset(new MappedFile(filename));
+	} catch (const system_error &error) {
+		// first run: nothing to reuse yet
+		if (error.code().value() == ENOENT)
+			return;
+		throw;
+	}
+
+	StringRef rest = mapping->contents();
+	const auto nextLine = [&]() -> StringRef {
+		const pair<StringRef, StringRef> split = rest.split('\n');
+		rest = split.second;
+		return split.first;
+	};
+
+	// results from another version may not mean the same thing
+	if (nextLine() != signature)
+		return;
+
+	while (!rest.empty()) {
+		SmallVector<StringRef, 3> fields;
+		nextLine().split(fields, " ");
+		uint64_t key;
+		unsigned count;
+		if (fields.size() != 3 || fields[0] != "component"
+		    || fields[1].getAsInteger(16, key) || fields[2].getAsInteger(10, count))
+			corrupt();
+
+		Component &component = previous[key];
+		component.resize(count);
+		for (Member &member : component) {
+			if (rest.empty())
+				corrupt();
+			fields.clear();
+			nextLine().split(fields, "\t");
+			if (fields.size() < 3 || fields.size() != fields[1].size() + 3 || fields[2].size() != fields[1].size())
+				corrupt();
+			member.name = fields[0].str();
+			for (const char digit : fields[1]) {
+				if (digit < '0' || digit > '2')
+					corrupt();
+				member.answers.push_back(digit - '0');
+			}
+			for (const char digit : fields[2]) {
+				if (digit < '0' || digit > '9')
+					corrupt();
+				member.reasons.push_back(digit - '0');
+			}
+			for (unsigned field = 3; field < fields.size(); ++field)
+				member.sources.push_back(fields[field].str());
+		}
+	}
+}
+
+
+IncrementalCache::IncrementalCache() {
+}
+
+
+void IncrementalCache::corrupt() const {
+	throw runtime_error("malformed incremental cache file " + filename);
+}
+
+
+shared_ptr<const IncrementalCache::Component> IncrementalCache::find(uint64_t key) const {
+	{
+		const lock_guard<mutex> lock(currentLock);
+		const auto found = current.find(key);
+		if (found != current.end())
+			return found->second;
+	}
+
+	// loaded components never change, so need no owner
+	const auto found = previous.find(key);
+	return found == previous.end() ? nullptr : shared_ptr<const Component>(shared_ptr<const Component>(), &found->second);
+}
+
+
+void IncrementalCache::record(uint64_t key, Component component) {
+	// a component being restored elsewhere keeps its old copy alive
+	const auto recorded = make_shared<const Component>(std::move(component));
+	const lock_guard<mutex> lock(currentLock);
+	current[key] = recorded;
+}
+
+
+void IncrementalCache::save() const {
+	// ordered by key, so identical runs write identical files
+	const auto out = openOutputFile(filename);
+	*out << signature << '\n';
+	for (const auto &entry : current) {
+		*out << "component ";
+		out->write_hex(entry.first);
+		*out << ' ' << entry.second->size() << '\n';
+		for (const Member &member : *entry.second) {
+			*out << member.name << '\t';
+			for (const uint8_t answer : member.answers)
+				*out << char('0' + answer);
+			*out << '\t';
+			for (const uint8_t reason : member.reasons)
+				*out << char('0' + reason);
+			for (const string &source : member.sources)
+				*out << '\t' << source;
+			*out << '\n';
+		}
+	}
+}
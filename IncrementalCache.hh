@@ -0,0 +1,64 @@
+#ifndef INCLUDE_INCREMENTAL_CACHE_HH
+#define INCLUDE_INCREMENTAL_CACHE_HH
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  NullAnnotator results for call graph components, saved from one run
+//  for reuse by the next
+//
+//  Each component is keyed by a hash of everything its results depend
+//  on: the code of its member functions, which of their arguments are
+//  arrays, and the final results of every callee outside the component.
+//  Loading an absent file yields an empty cache.  Saving keeps only the
+//  components recorded during this run, so stale entries never pile up.
+//
+//  Lookups also find components recorded since loading, so one cache
+//  kept in memory can serve many runs.  Lookups and recording may run
+//  concurrently.
+//
+
+class IncrementalCache {
+public:
+	// one function's results, in argument order: each argument's
+	// answer, reason code, and the name of the callee or loop header
+	// behind that reason, if any
+	struct Member {
+		std::string name;
+		std::vector<uint8_t> answers;
+		std::vector<uint8_t> reasons;
+		std::vector<std::string> sources;
+	};
+	typedef std::vector<Member> Component;
+
+	explicit IncrementalCache(const std::string &filename);
+
+	// start empty, for use in memory only; cannot be saved
+	IncrementalCache();
+
+	// results recorded by this or the previous run, if any
+	std::shared_ptr<const Component> find(uint64_t key) const;
+
+	// results to save for the next run
+	void record(uint64_t key, Component);
+	void save() const;
+
+private:
+	const std::string filename;
+	std::unordered_map<uint64_t, Component> previous;
+	std::map<uint64_t, std::shared_ptr<const Component>> current;
+	mutable std::mutex currentLock;
+
+	[[noreturn]] void corrupt() const;
+};
+
+
+#endif // !INCLUDE_INCREMENTAL_CACHE_HH
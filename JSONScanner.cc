@@ -0,0 +1,294 @@
+#include "JSONScanner.hh"
+
+#include <cstring>
+
+using namespace llvm;
+using namespace std;
+
+
+JSONScanner::Error::Error(const string &message, size_t offset)
+	: runtime_error(message + " at offset " + to_string(offset)),
+	  position(offset) {
+}
+
+
+JSONScanner::JSONScanner(StringRef text)
+	: begin(text.begin()),
+	  cursor(text.begin()),
+	  end(text.end()) {
+}
+
+
+void JSONScanner::fail(const string &message) const {
+	throw Error(message, offset());
+}
+
+
+void JSONScanner::skipWhitespace() {
+	while (cursor != end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\t' || *cursor == '\r'))
+		++cursor;
+}
+
+
+char JSONScanner::peek() {
+	skipWhitespace();
+	if (cursor == end)
+		fail("unexpected end of JSON input");
+	return *cursor;
+}
+
+
+void JSONScanner::expect(char expected) {
+	if (peek() != expected)
+		fail(string("expected '") + expected + "' but found '" + *cursor + '\'');
+	++cursor;
+}
+
+
+bool JSONScanner::atEnd() {
+	skipWhitespace();
+	return cursor == end;
+}
+
+
+void JSONScanner::enter(char opener, char closer) {
+	expect(opener);
+	levels.push_back({ closer, true });
+}
+
+
+void JSONScanner::enterContainer() {
+	if (atObject())
+		enterObject();
+	else
+		enterArray();
+}
+
+
+bool JSONScanner::nextEntry(char closer) {
+	if (levels.empty() || levels.back().closer != closer)
+		fail("container mismatch");
+
+	if (peek() == closer) {
+		++cursor;
+		levels.pop_back();
+		return false;
+	}
+
+	if (levels.back().first)
+		levels.back().first = false;
+	else
+		expect(',');
+	return true;
+}
+
+
+bool JSONScanner::nextMember(StringRef &key) {
+	if (!nextEntry('}'))
+		return false;
+	key = readRawString();
+	expect(':');
+	return true;
+}
+
+
+bool JSONScanner::nextValue() {
+	if (levels.empty())
+		fail("not inside a container");
+	if (levels.back().closer == ']')
+		return nextElement();
+
+	StringRef ignored;
+	return nextMember(ignored);
+}
+
+
+// cursor starts just after the opening quote, and ends just after
+// the closing quote
+void JSONScanner::skipString() {
+	for (;;) {
+		const void * const quote = memchr(cursor, '"', end - cursor);
+		if (!quote)
+			fail("unterminated string");
+
+		// quote is escaped only if preceded by an odd run of backslashes
+		const char * const found = static_cast<const char *>(quote);
+		const char *backslash = found;
+		while (backslash != cursor && backslash[-1] == '\\')
+			--backslash;
+		cursor = found + 1;
+		if ((found - backslash) % 2 == 0)
+			return;
+	}
+}
+
+
+// value of the four hex digits of a unicode escape, or -1 if malformed
+static int hexQuad(const char digits[]) {
+	int value = 0;
+	for (const char *digit = digits; digit != digits + 4; ++digit) {
+		value <<= 4;
+		if (*digit >= '0' && *digit <= '9')
+			value |= *digit - '0';
+		else if (*digit >= 'a' && *digit <= 'f')
+			value |= *digit - 'a' + 10;
+		else if (*digit >= 'A' && *digit <= 'F')
+			value |= *digit - 'A' + 10;
+		else
+			return -1;
+	}
+	return value;
+}
+
+
+StringRef JSONScanner::readRawString() {
+	expect('"');
+	const char * const start = cursor;
+	skipString();
+	return { start, size_t(cursor - 1 - start) };
+}
+
+
+string JSONScanner::readString() {
+	const StringRef raw = readRawString();
+	if (raw.find('\\') == StringRef::npos)
+		return raw.str();
+
+	string decoded;
+	decoded.reserve(raw.size());
+	for (const char *scan = raw.begin(); scan != raw.end(); ++scan) {
+		if (*scan != '\\') {
+			decoded += *scan;
+			continue;
+		}
+		switch (*++scan) {
+		case 'b': decoded += '\b'; break;
+		case 'f': decoded += '\f'; break;
+		case 'n': decoded += '\n'; break;
+		case 'r': decoded += '\r'; break;
+		case 't': decoded += '\t'; break;
+		case 'u': {
+			// encode code point as UTF-8
+			if (raw.end() - scan < 5)
+				fail("truncated unicode escape");
+			const int unit = hexQuad(scan + 1);
+			if (unit < 0)
+				fail("malformed unicode escape");
+			scan += 4;
+			unsigned point = unit;
+
+			// code points beyond the basic multilingual plane arrive as
+			// a high surrogate escape then a low surrogate escape
+			if (point >= 0xD800 && point < 0xDC00) {
+				if (raw.end() - scan < 7 || scan[1] != '\\' || scan[2] != 'u')
+					fail("unpaired surrogate in unicode escape");
+				const int low = hexQuad(scan + 3);
+				if (low < 0)
+					fail("malformed unicode escape");
+				if (low < 0xDC00 || low >= 0xE000)
+					fail("unpaired surrogate in unicode escape");
+				point = 0x10000 + ((point - 0xD800) << 10) + (low - 0xDC00);
+				scan += 6;
+			} else if (point >= 0xDC00 && point < 0xE000)
+				fail("unpaired surrogate in unicode escape");
+
+			if (point < 0x80)
+				decoded += char(point);
+			else if (point < 0x800) {
+				decoded += char(0xC0 | point >> 6);
+				decoded += char(0x80 | (point & 0x3F));
+			} else if (point < 0x10000) {
+				decoded += char(0xE0 | point >> 12);
+				decoded += char(0x80 | (point >> 6 & 0x3F));
+				decoded += char(0x80 | (point & 0x3F));
+			} else {
+				decoded += char(0xF0 | point >> 18);
+				decoded += char(0x80 | (point >> 12 & 0x3F));
+				decoded += char(0x80 | (point >> 6 & 0x3F));
+				decoded += char(0x80 | (point & 0x3F));
+			}
+			break;
+		}
+		default: decoded += *scan; break;
+		}
+	}
+	return decoded;
+}
+
+
+int64_t JSONScanner::readInteger() {
+	peek();
+	const bool negative = *cursor == '-';
+	if (negative) ++cursor;
+	if (cursor == end || *cursor < '0' || *cursor > '9')
+		fail("expected integer");
+
+	int64_t value = 0;
+	while (cursor != end && *cursor >= '0' && *cursor <= '9')
+		value = 10 * value + (*cursor++ - '0');
+	return negative ? -value : value;
+}
+
+
+namespace {
+	// characters that matter while skipping over a nested container
+	struct StructuralTable {
+		StructuralTable();
+		bool structural[256];
+	};
+}
+
+
+StructuralTable::StructuralTable()
+	: structural() {
+	for (const char c : { '"', '{', '}', '[', ']' })
+		structural[static_cast<unsigned char>(c)] = true;
+}
+
+
+void JSONScanner::skipValue() {
+	static const StructuralTable table;
+
+	switch (peek()) {
+	case '"':
+		++cursor;
+		skipString();
+		return;
+
+	case '{':
+	case '[': {
+		// only brackets and strings affect nesting, so everything
+		// else is passed over without being examined further
+		unsigned depth = 0;
+		do {
+			while (cursor != end && !table.structural[static_cast<unsigned char>(*cursor)])
+				++cursor;
+			if (cursor == end)
+				fail("unterminated container");
+			switch (*cursor++) {
+			case '"':
+				skipString();
+				break;
+			case '{':
+			case '[':
+				++depth;
+				break;
+			default:
+				--depth;
+				break;
+			}
+		} while (depth);
+		return;
+	}
+
+	default:
+		// number, true, false, or null
+		const char * const start = cursor;
+		while (cursor != end && *cursor != ',' && *cursor != '}' && *cursor != ']'
+		       && *cursor != ' ' && *cursor != '\n' && *cursor != '\t' && *cursor != '\r')
+			++cursor;
+		if (cursor == start)
+			fail("expected value");
+		return;
+	}
+}
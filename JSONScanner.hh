@@ -0,0 +1,122 @@
+#ifndef INCLUDE_JSON_SCANNER_HH
+#define INCLUDE_JSON_SCANNER_HH
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  streaming pull scanner for JSON text held in memory
+//
+//  Nothing is built for values the caller does not ask about: skipped
+//  values are stepped over by a table-driven scan for structural
+//  characters, and strings by searching for their closing quote with
+//  memchr().  Strings come back as raw slices of the input, so no
+//  copying happens unless the caller asks for escapes to be decoded.
+//
+//  Malformed input raises JSONScanner::Error.
+//
+
+class JSONScanner {
+public:
+	class Error : public std::runtime_error {
+	public:
+		Error(const std::string &message, size_t offset);
+		size_t offset() const;
+
+	private:
+		size_t position;
+	};
+
+	explicit JSONScanner(llvm::StringRef text);
+
+	// walk containers; next*() returns false at the closing bracket
+	void enterObject();
+	bool nextMember(llvm::StringRef &key);
+	void enterArray();
+	bool nextElement();
+
+	// walk either kind of container, ignoring any object keys
+	void enterContainer();
+	bool nextValue();
+
+	// scalar values
+	llvm::StringRef readRawString();
+	std::string readString();
+	int64_t readInteger();
+	void skipValue();
+
+	// what kind of value comes next
+	bool atObject();
+	bool atArray();
+
+	// position just after the top-level value
+	bool atEnd();
+	size_t offset() const;
+
+private:
+	const char * const begin;
+	const char *cursor;
+	const char * const end;
+
+	// closing bracket and "no members yet" flag per open container
+	struct Level {
+		char closer;
+		bool first;
+	};
+	llvm::SmallVector<Level, 8> levels;
+
+	char peek();
+	void expect(char);
+	void skipWhitespace();
+	void skipString();
+	bool nextEntry(char closer);
+	void enter(char opener, char closer);
+	[[noreturn]] void fail(const std::string &message) const;
+};
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline size_t JSONScanner::Error::offset() const {
+	return position;
+}
+
+
+inline size_t JSONScanner::offset() const {
+	return cursor - begin;
+}
+
+
+inline void JSONScanner::enterObject() {
+	enter('{', '}');
+}
+
+
+inline void JSONScanner::enterArray() {
+	enter('[', ']');
+}
+
+
+inline bool JSONScanner::nextElement() {
+	return nextEntry(']');
+}
+
+
+inline bool JSONScanner::atObject() {
+	return peek() == '{';
+}
+
+
+inline bool JSONScanner::atArray() {
+	return peek() == '[';
+}
+
+
+#endif // !INCLUDE_JSON_SCANNER_HH
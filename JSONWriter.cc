@@ -0,0 +1,31 @@
+#include "JSONWriter.hh"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+
+void writeJSONString(raw_ostream &out, StringRef text) {
+	out << '"';
+	for (const char c : text) {
+		switch (c) {
+		case '"':
+		case '\\':
+			out << '\\' << c;
+			break;
+		case '\n':
+			out << "\\n";
+			break;
+		case '\t':
+			out << "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+				out << format("\\u%04x", c);
+			else
+				out << c;
+		}
+	}
+	out << '"';
+}
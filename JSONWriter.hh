@@ -0,0 +1,20 @@
+#ifndef INCLUDE_JSON_WRITER_HH
+#define INCLUDE_JSON_WRITER_HH
+
+#include <llvm/ADT/StringRef.h>
+
+namespace llvm {
+	class raw_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  write text as a quoted JSON string, escaping whatever JSON requires
+//  and nothing else, so JSONScanner::readString() gets it back intact
+//
+
+void writeJSONString(llvm::raw_ostream &, llvm::StringRef);
+
+
+#endif // !INCLUDE_JSON_WRITER_HH
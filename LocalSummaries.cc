@@ -0,0 +1,154 @@
+#include "FindSentinels.hh"
+#include "IIGlueReader.hh"
+#include "LocalSummaries.hh"
+#include "LocalSummaryFile.hh"
+#include "OutputFile.hh"
+#include "ReachingArguments.hh"
+#include "Trace.hh"
+
+#include <algorithm>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  phase one of two-phase analysis: record what each function's own
+//  code says about its array arguments, leaving propagation across
+//  calls to solve-summaries
+//
+
+namespace {
+	class LocalSummaries : public ModulePass {
+	public:
+		// standard LLVM pass interface
+		LocalSummaries();
+		explicit LocalSummaries(raw_ostream *output);
+		static char ID;
+		void getAnalysisUsage(AnalysisUsage &) const final override;
+		bool runOnModule(Module &) final override;
+		void print(raw_ostream &, const Module *) const final override;
+
+	private:
+		const string outputFile;
+		// where summaries go instead of the output file, if anywhere
+		raw_ostream * const outputStream;
+		ModuleSummary summary;
+		LocalSummary summarize(const Function &, const IIGlueReader &, const FindSentinels &, ReachingArguments &) const;
+	};
+
+
+	char LocalSummaries::ID;
+	static const RegisterPass<LocalSummaries> registration("local-summaries",
+		"Summarize each function's sentinel checks and argument flow into callees, for solve-summaries",
+		true, true);
+	static cl::opt<string>
+		outputFileName("local-summaries-output",
+			cl::Optional,
+			cl::value_desc("filename"),
+			cl::desc("Filename to write local summaries to"));
+}
+
+
+inline LocalSummaries::LocalSummaries()
+	: ModulePass(ID),
+	  outputFile(outputFileName),
+	  outputStream(nullptr) {
+}
+
+
+inline LocalSummaries::LocalSummaries(raw_ostream *output)
+	: ModulePass(ID),
+	  outputStream(output) {
+}
+
+
+ModulePass *createLocalSummaries(raw_ostream *output) {
+	return new LocalSummaries(output);
+}
+
+
+void LocalSummaries::getAnalysisUsage(AnalysisUsage &usage) const {
+	// read-only pass never changes anything
+	usage.setPreservesAll();
+	usage.addRequired<IIGlueReader>();
+	usage.addRequired<FindSentinels>();
+	usage.addRequired<ReachingArguments>();
+}
+
+
+LocalSummary LocalSummaries::summarize(const Function &function, const IIGlueReader &iiglue, const FindSentinels &findSentinels, ReachingArguments &reachingArguments) const {
+	const TraceScope tracing("summarize function", function.getName());
+	LocalSummary local;
+	local.name = function.getName().str();
+	local.local = function.hasLocalLinkage();
+
+	const FindSentinels::FunctionResults * const checks =
+		iiglue.isArrayReceiver(function) ? findSentinels.getResultsForFunction(&function) : nullptr;
+	for (const Argument &arg : function.getArgumentList()) {
+		const bool isArray = iiglue.isArray(arg);
+		local.argumentNames.push_back(arg.getName().str());
+		local.arrays.push_back(isArray);
+		if (!isArray || !checks)
+			local.checks.push_back(NoCheck);
+		else if (checks->loopWithNonOptionalSentinelCheck(arg))
+			local.checks.push_back(NonOptionalCheck);
+		else if (checks->loopWithSentinelCheck(arg))
+			local.checks.push_back(OptionalCheck);
+		else
+			local.checks.push_back(NoCheck);
+	}
+
+	// only array arguments can pick up answers from callees
+	if (!iiglue.isArrayReceiver(function))
+		return local;
+
+	for (const BasicBlock &block : function)
+		for (const Instruction &instruction : block) {
+			const CallInst * const call = dyn_cast<CallInst>(&instruction);
+			if (!call || !call->getCalledFunction())
+				continue;
+			const Function &callee = *call->getCalledFunction();
+
+			// extra actuals passed to variadic callees have no parameter
+			const unsigned parameters = min<unsigned>(call->getNumArgOperands(), callee.arg_size());
+			for (unsigned parameter = 0; parameter < parameters; ++parameter) {
+				const SmallBitVector &reaching = reachingArguments(*call->getArgOperand(parameter));
+				for (int argNo = reaching.find_first(); argNo != -1; argNo = reaching.find_next(argNo))
+					if (local.arrays[argNo])
+						local.calls.push_back({ unsigned(argNo), callee.getName().str(), parameter, unsigned(callee.arg_size()) });
+			}
+		}
+	return local;
+}
+
+
+bool LocalSummaries::runOnModule(Module &module) {
+	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
+	const FindSentinels &findSentinels = getAnalysis<FindSentinels>();
+	ReachingArguments &reachingArguments = getAnalysis<ReachingArguments>();
+
+	summary.module = module.getModuleIdentifier();
+	for (const Function &function : module)
+		if (!function.isDeclaration())
+			summary.functions.push_back(summarize(function, iiglue, findSentinels, reachingArguments));
+
+	if (outputStream) {
+		const TraceScope tracing("write local summaries", summary.module);
+		summary.write(*outputStream);
+	} else if (!outputFile.empty()) {
+		const TraceScope tracing("write local summaries", outputFile);
+		summary.write(*openOutputFile(outputFile));
+	}
+	return false;
+}
+
+
+void LocalSummaries::print(raw_ostream &sink, const Module *) const {
+	summary.write(sink);
+}
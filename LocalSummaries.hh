@@ -0,0 +1,20 @@
+#ifndef INCLUDE_LOCAL_SUMMARIES_HH
+#define INCLUDE_LOCAL_SUMMARIES_HH
+
+namespace llvm {
+	class ModulePass;
+	class raw_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  pass writing a module's local summaries to the given stream rather
+//  than the "-local-summaries-output" file, for drivers that run it on
+//  many modules; a null stream writes nothing
+//
+
+llvm::ModulePass *createLocalSummaries(llvm::raw_ostream *output);
+
+
+#endif // !INCLUDE_LOCAL_SUMMARIES_HH
@@ -0,0 +1,152 @@
+#include "JSONScanner.hh"
+#include "JSONWriter.hh"
+#include "LocalSummaryFile.hh"
+#include "MappedFile.hh"
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  layout, with one function per line:
+//
+//      {"module": "foo.bc", "functions": [
+//      {"name": "f", "local": 0, "argument_names": ["s", "n"],
+//       "args_array_receivers": [1, 0], "sentinel_checks": [2, 0],
+//       "calls": [[0, "g", 1, 2]]},
+//      ...
+//      ]}
+//
+//  Each call entry is [argument, callee, callee parameter, callee
+//  arity].
+//
+
+template <typename Elements, typename Write>
+static void writeArray(raw_ostream &out, const Elements &elements, const Write &write) {
+	out << '[';
+	bool first = true;
+	for (const auto &element : elements) {
+		if (!first)
+			out << ", ";
+		first = false;
+		write(element);
+	}
+	out << ']';
+}
+
+
+void ModuleSummary::write(raw_ostream &out) const {
+	out << "{\"module\": ";
+	writeJSONString(out, module);
+	out << ", \"functions\": [";
+	for (const LocalSummary &function : functions) {
+		out << (&function == &functions.front() ? "\n" : ",\n")
+		    << "{\"name\": ";
+		writeJSONString(out, function.name);
+		out << ", \"local\": " << function.local
+		    << ", \"argument_names\": ";
+		writeArray(out, function.argumentNames, [&](const string &name) { writeJSONString(out, name); });
+		out << ", \"args_array_receivers\": ";
+		writeArray(out, function.arrays, [&](bool isArray) { out << isArray; });
+		out << ", \"sentinel_checks\": ";
+		writeArray(out, function.checks, [&](SentinelVerdict verdict) { out << unsigned(verdict); });
+		out << ", \"calls\": ";
+		writeArray(out, function.calls, [&](const LocalSummary::Call &call) {
+				out << '[' << call.argument << ", ";
+				writeJSONString(out, call.callee);
+				out << ", " << call.parameter << ", " << call.arity << ']';
+			});
+		out << '}';
+	}
+	out << "\n]}\n";
+}
+
+
+ModuleSummary ModuleSummary::read(const string &filename) {
+	const MappedFile contents(filename);
+	JSONScanner scanner(contents.contents());
+	ModuleSummary summary;
+
+	const auto malformed = [&](const string &problem) {
+		throw JSONScanner::Error(problem + " in local summaries " + filename, scanner.offset());
+	};
+	const auto nextField = [&]() {
+		if (!scanner.nextElement())
+			malformed("truncated call entry");
+	};
+
+	scanner.enterObject();
+	StringRef key;
+	while (scanner.nextMember(key)) {
+		if (key == "module") {
+			summary.module = scanner.readString();
+			continue;
+		}
+		if (key != "functions") {
+			scanner.skipValue();
+			continue;
+		}
+
+		scanner.enterArray();
+		while (scanner.nextElement()) {
+			summary.functions.emplace_back();
+			LocalSummary &function = summary.functions.back();
+			function.local = false;
+
+			scanner.enterObject();
+			while (scanner.nextMember(key)) {
+				if (key == "name")
+					function.name = scanner.readString();
+				else if (key == "local")
+					function.local = scanner.readInteger();
+				else if (key == "argument_names") {
+					scanner.enterArray();
+					while (scanner.nextElement())
+						function.argumentNames.push_back(scanner.readString());
+				} else if (key == "args_array_receivers") {
+					scanner.enterArray();
+					while (scanner.nextElement())
+						function.arrays.push_back(scanner.readInteger());
+				} else if (key == "sentinel_checks") {
+					scanner.enterArray();
+					while (scanner.nextElement()) {
+						const int64_t verdict = scanner.readInteger();
+						if (verdict < NoCheck || verdict > NonOptionalCheck)
+							malformed("unknown sentinel check verdict for " + function.name);
+						function.checks.push_back(static_cast<SentinelVerdict>(verdict));
+					}
+				} else if (key == "calls") {
+					scanner.enterArray();
+					while (scanner.nextElement()) {
+						LocalSummary::Call call;
+						scanner.enterArray();
+						nextField();
+						call.argument = scanner.readInteger();
+						nextField();
+						call.callee = scanner.readString();
+						nextField();
+						call.parameter = scanner.readInteger();
+						nextField();
+						call.arity = scanner.readInteger();
+						if (scanner.nextElement())
+							malformed("overlong call entry");
+						function.calls.push_back(std::move(call));
+					}
+				} else
+					scanner.skipValue();
+			}
+
+			const size_t arity = function.argumentNames.size();
+			if (function.arrays.size() != arity || function.checks.size() != arity)
+				malformed("inconsistent argument counts for " + function.name);
+			for (const LocalSummary::Call &call : function.calls)
+				if (call.argument >= arity || call.parameter >= call.arity)
+					malformed("call from or to nonexistent argument in " + function.name);
+		}
+	}
+
+	return summary;
+}
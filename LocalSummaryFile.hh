@@ -0,0 +1,61 @@
+#ifndef INCLUDE_LOCAL_SUMMARY_FILE_HH
+#define INCLUDE_LOCAL_SUMMARY_FILE_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm {
+	class raw_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  everything NullAnnotator learns about one module's functions
+//  without looking beyond that module, as JSON
+//
+//  For each defined function: which arguments iiglue calls arrays,
+//  what sentinel checks guard each of them, and which callee
+//  parameters each array argument may flow into.  Answers follow from
+//  these alone, so a whole program can be solved from its modules'
+//  local summaries without loading any bitcode.
+//
+
+enum SentinelVerdict : uint8_t {
+	NoCheck,
+	OptionalCheck,
+	NonOptionalCheck
+};
+
+
+struct LocalSummary {
+	// some array argument may flow into some callee parameter; the
+	// callee's arity is kept for checking against dependency results
+	struct Call {
+		unsigned argument;
+		std::string callee;
+		unsigned parameter;
+		unsigned arity;
+	};
+
+	std::string name;
+	// internal linkage: callable only from its own module
+	bool local;
+	std::vector<std::string> argumentNames;
+	std::vector<bool> arrays;
+	std::vector<SentinelVerdict> checks;
+	std::vector<Call> calls;
+};
+
+
+struct ModuleSummary {
+	std::string module;
+	std::vector<LocalSummary> functions;
+
+	void write(llvm::raw_ostream &) const;
+	static ModuleSummary read(const std::string &filename);
+};
+
+
+#endif // !INCLUDE_LOCAL_SUMMARY_FILE_HH
@@ -0,0 +1,52 @@
+#include "MappedFile.hh"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace std;
+
+
+static system_error failure(const string &operation, const string &filename) {
+	return { errno, system_category(), operation + ' ' + filename };
+}
+
+
+MappedFile::MappedFile(const string &filename)
+	: start(nullptr),
+	  length(0) {
+	const int descriptor = open(filename.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		throw failure("cannot open", filename);
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		const auto error = failure("cannot stat", filename);
+		close(descriptor);
+		throw error;
+	}
+
+	// mmap() rejects empty mappings, but an empty file is still valid
+	length = status.st_size;
+	if (length) {
+		void * const mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (mapped == MAP_FAILED) {
+			const auto error = failure("cannot map", filename);
+			close(descriptor);
+			throw error;
+		}
+		start = static_cast<const char *>(mapped);
+		madvise(mapped, length, MADV_SEQUENTIAL);
+	}
+
+	close(descriptor);
+}
+
+
+MappedFile::~MappedFile() {
+	if (length)
+		munmap(const_cast<char *>(start), length);
+}
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_MAPPED_FILE_HH
+#define INCLUDE_MAPPED_FILE_HH
+
+#include <llvm/ADT/StringRef.h>
+
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  read-only memory mapping of an entire file
+//
+//  Throws std::system_error if the file cannot be opened or mapped.
+//
+
+class MappedFile {
+public:
+	explicit MappedFile(const std::string &filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const char *data() const;
+	size_t size() const;
+	llvm::StringRef contents() const;
+
+private:
+	const char *start;
+	size_t length;
+};
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline const char *MappedFile::data() const {
+	return start;
+}
+
+
+inline size_t MappedFile::size() const {
+	return length;
+}
+
+
+inline llvm::StringRef MappedFile::contents() const {
+	return { start, length };
+}
+
+
+#endif // !INCLUDE_MAPPED_FILE_HH
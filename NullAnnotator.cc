@@ -1,25 +1,40 @@
 #define DEBUG_TYPE "null-annotator"
 #include "Answer.hh"
-#include "BacktrackPhiNodes.hh"
+#include "Counters.hh"
+#include "Dependencies.hh"
 #include "FindSentinels.hh"
 #include "IIGlueReader.hh"
+#include "IncrementalCache.hh"
+#include "JSONWriter.hh"
+#include "NullAnnotator.hh"
+#include "OutputFile.hh"
+#include "Parallel.hh"
+#include "ReachingArguments.hh"
+#include "Reason.hh"
+#include "StronglyConnected.hh"
+#include "StructuralHash.hh"
+#include "SummaryFile.hh"
+#include "Trace.hh"
 
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lambda/core.hpp>
-#include <boost/property_tree/json_parser.hpp>
 #include <boost/range/adaptor/filtered.hpp>
-#include <boost/range/adaptor/map.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/combine.hpp>
 #include <boost/range/irange.hpp>
 #include <boost/range/iterator_range.hpp>
-#include <fstream>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <llvm/ADT/SmallBitVector.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/ValueSymbolTable.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/raw_ostream.h>
 
 #if (1000 * LLVM_VERSION_MAJOR + LLVM_VERSION_MINOR) >= 3005
 #include <llvm/IR/InstIterator.h>
@@ -30,16 +45,29 @@
 using namespace boost;
 using namespace boost::adaptors;
 using namespace boost::algorithm;
-using namespace boost::property_tree;
 using namespace llvm;
 using namespace std;
 
 
+static Counter operandLookups("null-annotator", "operand-lookups");
+static Counter dependencyEdges("null-annotator", "dependency-edges");
+static Counter argumentVisits("null-annotator", "argument-visits");
+static Counter argumentRequeues("null-annotator", "argument-requeues");
+static Counter fixedPointRounds("null-annotator", "fixed-point-rounds");
+static Counter componentsSolved("null-annotator", "components");
+static Counter componentsReused("null-annotator", "cache-hits");
+static MemoryGauge resultsHeld("null-annotator", "results");
+static MemoryGauge callSitesHeld("null-annotator", "functionToCallSites");
+static MemoryGauge dependenciesHeld("null-annotator", "dependency-graph");
+
+
 namespace {
 	class NullAnnotator : public ModulePass {
 	public:
 		// standard LLVM pass interface
 		NullAnnotator();
+		NullAnnotator(const Dependencies &, raw_ostream *output, vector<SummaryFile::Summary> *summaries);
+		NullAnnotator(const Dependencies &, raw_ostream &output, IncrementalCache *, vector<string> queries);
 		static char ID;
 		void getAnalysisUsage(AnalysisUsage &) const final override;
 		bool runOnModule(Module &) final override;
@@ -48,16 +76,100 @@ namespace {
 		// access to analysis results derived by this pass
 		bool annotate(const Argument &) const;
 
+		// final answer for one argument, first solving its function
+		// and transitive callees if they are not final yet; solved
+		// functions stay final, so asking again is just a lookup
+		Answer getAnswer(const Function &, unsigned argument);
+
 	private:
-		// map from function name and argument number to whether or not that argument gets annotated
-		typedef unordered_map<const Argument *, Answer> AnnotationMap;
-		AnnotationMap annotations;
-		unordered_map<const Argument *, string> reasons;
-		typedef unordered_set<const CallInst *> CallInstSet;
-		unordered_map<const Function *, CallInstSet> functionToCallSites;
+		// why an argument has its annotation; text is only built for output
+		struct Reason {
+			ReasonCode code;
+			// callee function or loop header justifying the code, if known
+			const Value *source;
+		};
+
+		// each function's results, indexed by argument number; created
+		// for every function up front and never resized afterward
+		struct ArgumentResult {
+			Answer answer;
+			Reason reason;
+		};
+		typedef vector<ArgumentResult> ResultTable;
+		unordered_map<const Function *, ResultTable> results;
+		ArgumentResult &result(const Argument &);
+		const ArgumentResult &result(const Argument &) const;
+		void record(const Argument &, Answer, ReasonCode, const Value *source);
+
+		typedef vector<const CallInst *> CallInstList;
+		unordered_map<const Function *, CallInstList> functionToCallSites;
 		Answer getAnswer(const Argument &) const;
-		void dumpToFile(const string &filename, const IIGlueReader &, const Module &) const;
-		void populateFromFile(const string &filename, const Module &);
+
+		// formal arguments that may flow into each operand of each call
+		struct OperandSources {
+			const CallInst *call;
+			unsigned operand;
+			SmallBitVector arguments;
+		};
+		typedef vector<OperandSources> ReachabilityIndex;
+		unordered_map<const Function *, ReachabilityIndex> functionToOperandSources;
+		void buildReachabilityIndex(const Function &, ReachingArguments &);
+
+		// argument-level dependency graph between callers and callees
+		typedef vector<const Argument *> ArgumentList;
+		unordered_map<const Argument *, ArgumentList> calleeParameters;
+		unordered_map<const Argument *, ArgumentList> dependentArguments;
+		void addDependencies(const Function &, const IIGlueReader &, ReachingArguments &);
+		void buildDependencyGraph(const IIGlueReader &, ReachingArguments &);
+		bool update(const Argument &, const FindSentinels::FunctionResults *);
+		void solve(const vector<const Function *> &, const IIGlueReader &, const FindSentinels &);
+		void solveDemanded(const vector<const Function *> &roots, const IIGlueReader &, const FindSentinels &, ReachingArguments &);
+		void measureMemory() const;
+
+		// call graph components among array receivers, bottom-up; a
+		// function is final once it has a component
+		unsigned componentCount;
+		unordered_map<const Function *, unsigned> componentOf;
+		void solveComponent(const vector<const Function *> &, unsigned component, const IIGlueReader &, const FindSentinels &);
+
+		// results reused from earlier runs, for unchanged components;
+		// either shared by the driver or read from the cache file
+		IncrementalCache *cache;
+		unique_ptr<IncrementalCache> ownCache;
+		atomic<unsigned> cacheHits;
+		atomic<unsigned> cacheMisses;
+		uint64_t componentKey(const vector<const Function *> &, unsigned component, const IIGlueReader &) const;
+		bool restoreComponent(const vector<const Function *> &, const IncrementalCache::Component &, const IIGlueReader &);
+		IncrementalCache::Component saveComponent(const vector<const Function *> &) const;
+		void solveIncrementally(const vector<const Function *> &, unsigned component, const IIGlueReader &, const FindSentinels &);
+		void dumpFunction(raw_ostream &, const Function &, const IIGlueReader &, const char prefix[], const char separator[]) const;
+		void dumpJSON(raw_ostream &, const IIGlueReader &, const vector<const Function *> &) const;
+		void dumpSummary(raw_ostream &, const vector<const Function *> &) const;
+		vector<SummaryFile::Summary> summarize(const vector<const Function *> &) const;
+
+		// functions to solve and report instead of the whole module,
+		// if any, by name and as found in the module
+		const vector<string> queryNames;
+		vector<const Function *> queried;
+		vector<const Function *> reportedFunctions(const Module &) const;
+
+		// JSON Lines output, written as each function becomes final
+		raw_ostream *records;
+		mutex recordsLock;
+		void dumpRecords(const vector<const Function *> &, const IIGlueReader &);
+
+		// results for dependencies, either shared with other runs or
+		// read from "-dependency" files for this run alone
+		const Dependencies *dependencies;
+		unique_ptr<Dependencies> ownDependencies;
+		const string outputFile;
+
+		// where results go instead of the output file, if anywhere
+		raw_ostream * const outputStream;
+		raw_ostream &openOutput(unique_ptr<raw_fd_ostream> &file) const;
+
+		// final results handed to the driver in memory, if wanted
+		vector<SummaryFile::Summary> * const summaries;
 	};
 
 
@@ -65,86 +177,118 @@ namespace {
 	static const RegisterPass<NullAnnotator> registration("null-annotator",
 		"Determine whether and how to annotate each function with the null-terminated annotation",
 		true, true);
-	static cl::list<string>
-		dependencyFileNames("dependency",
-			cl::ZeroOrMore,
-			cl::value_desc("filename"),
-			cl::desc("Filename containing NullAnnotator results for dependencies; use multiple times to read multiple files"));
 	static cl::opt<string>
 		outputFileName("output",
 			cl::Optional,
 			cl::value_desc("filename"),
 			cl::desc("Filename to write results to"));
+	enum OutputFormat {
+		OutputJSON,
+		OutputJSONLines,
+		OutputSummary
+	};
+	static cl::opt<OutputFormat>
+		outputFormat("output-format",
+			cl::init(OutputJSON),
+			cl::desc("Format of results written to the output file"),
+			cl::values(
+				clEnumValN(OutputJSON, "json", "one JSON object covering all functions, written at the end"),
+				clEnumValN(OutputJSONLines, "jsonl", "one JSON object per line per function, written as soon as each is final"),
+				clEnumValN(OutputSummary, "summary", "binary summary, for fast loading with -dependency"),
+				clEnumValEnd));
+	static cl::opt<unsigned>
+		threadCount("null-annotator-threads",
+			cl::init(1),
+			cl::value_desc("count"),
+			cl::desc("Number of threads used to solve independent call graph components"));
+	static cl::opt<string>
+		cacheFileName("null-annotator-cache",
+			cl::Optional,
+			cl::value_desc("filename"),
+			cl::desc("File of results kept between runs; functions whose code and callee results are unchanged are not reanalyzed"));
+	static cl::list<string>
+		queryFunctionNames("null-annotator-query",
+			cl::ZeroOrMore,
+			cl::value_desc("function"),
+			cl::desc("Analyze only this function and its transitive callees instead of the whole module; use multiple times to query several functions"));
 }
 
 
-static bool existsNonOptionalSentinelCheck(const FindSentinels::FunctionResults *checks, const Argument &arg) {
-	if (checks == nullptr)
-		return false;
-	return any_of(*checks | map_values,
-		      [&](const ArgumentToBlockSet &entry) { return !entry.at(&arg).second; });
+// header of some loop with a non-optional sentinel check, if any
+static const BasicBlock *existsNonOptionalSentinelCheck(const FindSentinels::FunctionResults *checks, const Argument &arg) {
+	return checks == nullptr ? nullptr : checks->loopWithNonOptionalSentinelCheck(arg);
 }
 
 
-static bool hasLoopWithSentinelCheck(const FindSentinels::FunctionResults *checks, const Argument &arg) {
-	if (checks == nullptr)
-		return false;
-	return any_of(*checks | map_values,
-		      [&](const ArgumentToBlockSet &entry) { return !entry.at(&arg).first.empty(); });
+// header of some loop with any sentinel check, if any
+static const BasicBlock *hasLoopWithSentinelCheck(const FindSentinels::FunctionResults *checks, const Argument &arg) {
+	return checks == nullptr ? nullptr : checks->loopWithSentinelCheck(arg);
 }
 
 
 ////////////////////////////////////////////////////////////////////////
-//
-//  test whether a specific argument may flow into a specific value
-//  across zero or more phi nodes
-//
 
-namespace {
-	class ArgumentReachesValue : public BacktrackPhiNodes {
-	public:
-		ArgumentReachesValue(const Argument &);
-		void visit(const Argument &) final override;
 
-	private:
-		const Argument &goal;
-	};
+inline NullAnnotator::NullAnnotator()
+	: ModulePass(ID),
+	  componentCount(0),
+	  cache(nullptr),
+	  cacheHits(0),
+	  cacheMisses(0),
+	  queryNames(queryFunctionNames.begin(), queryFunctionNames.end()),
+	  records(nullptr),
+	  dependencies(nullptr),
+	  outputFile(outputFileName),
+	  outputStream(nullptr),
+	  summaries(nullptr) {
 }
 
 
-inline ArgumentReachesValue::ArgumentReachesValue(const Argument &goal)
-	: goal(goal) {
+inline NullAnnotator::NullAnnotator(const Dependencies &dependencies, raw_ostream *output, vector<SummaryFile::Summary> *summaries)
+	: ModulePass(ID),
+	  componentCount(0),
+	  cache(nullptr),
+	  cacheHits(0),
+	  cacheMisses(0),
+	  queryNames(queryFunctionNames.begin(), queryFunctionNames.end()),
+	  records(nullptr),
+	  dependencies(&dependencies),
+	  outputStream(output),
+	  summaries(summaries) {
 }
 
 
-void ArgumentReachesValue::visit(const Argument &reached) {
-	if (&reached == &goal)
-		throw this;
+inline NullAnnotator::NullAnnotator(const Dependencies &dependencies, raw_ostream &output, IncrementalCache *cache, vector<string> queries)
+	: ModulePass(ID),
+	  componentCount(0),
+	  cache(cache),
+	  cacheHits(0),
+	  cacheMisses(0),
+	  queryNames(std::move(queries)),
+	  records(nullptr),
+	  dependencies(&dependencies),
+	  outputStream(&output),
+	  summaries(nullptr) {
 }
 
 
-static bool argumentReachesValue(const Argument &goal, const Value &start) {
-	ArgumentReachesValue explorer(goal);
-	try {
-		explorer.backtrack(start);
-	} catch (const ArgumentReachesValue *) {
-		return true;
-	}
-	return false;
+ModulePass *createNullAnnotator(const Dependencies &dependencies, raw_ostream *output, vector<SummaryFile::Summary> *summaries) {
+	return new NullAnnotator(dependencies, output, summaries);
 }
 
 
-////////////////////////////////////////////////////////////////////////
+ModulePass *createNullAnnotator(const Dependencies &dependencies, raw_ostream &output, IncrementalCache *cache, vector<string> queries) {
+	return new NullAnnotator(dependencies, output, cache, std::move(queries));
+}
 
 
-inline NullAnnotator::NullAnnotator()
-	: ModulePass(ID) {
+Answer getNullAnnotatorAnswer(ModulePass &annotator, const Function &function, unsigned argument) {
+	return static_cast<NullAnnotator &>(annotator).getAnswer(function, argument);
 }
 
 
 bool NullAnnotator::annotate(const Argument &arg) const {
-	const AnnotationMap::const_iterator found = annotations.find(&arg);
-	return found != annotations.end() && found->second == NULL_TERMINATED;
+	return getAnswer(arg) == NULL_TERMINATED;
 }
 
 
@@ -153,232 +297,649 @@ void NullAnnotator::getAnalysisUsage(AnalysisUsage &usage) const {
 	usage.setPreservesAll();
 	usage.addRequired<IIGlueReader>();
 	usage.addRequired<FindSentinels>();
+	usage.addRequired<ReachingArguments>();
+}
+
+
+inline NullAnnotator::ArgumentResult &NullAnnotator::result(const Argument &arg) {
+	return results.at(arg.getParent())[arg.getArgNo()];
+}
+
+
+inline const NullAnnotator::ArgumentResult &NullAnnotator::result(const Argument &arg) const {
+	return results.at(arg.getParent())[arg.getArgNo()];
 }
 
 
 Answer NullAnnotator::getAnswer(const Argument &arg) const {
-	const AnnotationMap::const_iterator found = annotations.find(&arg);
-	return found == annotations.end() ? DONT_CARE : found->second;
+	return result(arg).answer;
 }
 
 
-void NullAnnotator::populateFromFile(const string &filename, const Module &module) {
-	ptree root;
-	read_json(filename, root);
-	const ptree &libraryFunctions = root.get_child("library_functions");
-	for (const auto &framePair : libraryFunctions) {
-		// find corresponding LLVM function object
-		const string &name = framePair.first;
-		const Function * const function = module.getFunction(name);
-		if (!function) {
-			errs() << "warning: found function " << name << " in iiglue results but not in bitcode\n";
+// analyses are fetched again rather than kept, as this may be called
+// after runOnModule for as long as the pass manager exists
+Answer NullAnnotator::getAnswer(const Function &function, unsigned argument) {
+	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
+	if (iiglue.isArrayReceiver(function) && !componentOf.count(&function))
+		solveDemanded({ &function }, iiglue, getAnalysis<FindSentinels>(), getAnalysis<ReachingArguments>());
+	return results.at(&function)[argument].answer;
+}
+
+
+inline void NullAnnotator::record(const Argument &arg, Answer answer, ReasonCode code, const Value *source) {
+	result(arg) = { answer, { code, source } };
+}
+
+
+template<typename Detail> static
+void dumpArgumentDetails(raw_ostream &out, const Function::ArgumentListType &argumentList, const char prefix[], const char key[], const Detail &detail) {
+	out << prefix << '\"' << key << "\": [";
+	for (const Argument &argument : argumentList) {
+		if (&argument != argumentList.begin())
+			out << ", ";
+		detail(argument);
+	}
+	out << ']';
+}
+
+
+void NullAnnotator::dumpFunction(raw_ostream &out, const Function &function, const IIGlueReader &iiglue, const char prefix[], const char separator[]) const {
+	const Function::ArgumentListType &argumentList = function.getArgumentList();
+
+	dumpArgumentDetails(out, argumentList, prefix, "argument_names",
+			    [&](const Argument &arg) {
+				    writeJSONString(out, arg.getName());
+			    }
+		);
+	out << separator;
+
+	dumpArgumentDetails(out, argumentList, prefix, "argument_annotations",
+			    [&](const Argument &arg) {
+				    out << getAnswer(arg);
+			    }
+		);
+	out << separator;
+
+	dumpArgumentDetails(out, argumentList, prefix, "args_array_receivers",
+			    [&](const Argument &arg) {
+				    out << iiglue.isArray(arg);
+			    }
+		);
+	out << separator;
+
+	dumpArgumentDetails(out, argumentList, prefix, "argument_reasons",
+			    [&](const Argument &arg) {
+				    const Reason &reason = result(arg).reason;
+				    writeJSONString(out, describeReason(reason.code, reason.source ? reason.source->getName() : StringRef()));
+			    }
+		);
+}
+
+
+void NullAnnotator::dumpJSON(raw_ostream &out, const IIGlueReader &iiglue, const vector<const Function *> &functions) const {
+	out << "{\n\t\"library_functions\": {";
+	const char *separator = "\n";
+	for (const Function &function : functions | indirected) {
+		out << separator;
+		separator = ",\n";
+
+		out << "\t\t";
+		writeJSONString(out, function.getName());
+		out << ": {\n";
+		dumpFunction(out, function, iiglue, "\t\t\t", ",\n");
+		out << "\n\t\t}";
+	}
+	out << "\n\t}\n}\n";
+}
+
+
+vector<SummaryFile::Summary> NullAnnotator::summarize(const vector<const Function *> &functions) const {
+	vector<SummaryFile::Summary> summaries;
+	summaries.reserve(functions.size());
+	for (const Function &function : functions | indirected) {
+		summaries.push_back({ function.getName().str(), {} });
+		for (const Argument &arg : function.getArgumentList())
+			summaries.back().answers.push_back(getAnswer(arg));
+	}
+	return summaries;
+}
+
+
+void NullAnnotator::dumpSummary(raw_ostream &out, const vector<const Function *> &functions) const {
+	SummaryFile::write(out, summarize(functions));
+}
+
+
+// the driver's stream if it gave one, else the output file, opened
+// into file
+raw_ostream &NullAnnotator::openOutput(unique_ptr<raw_fd_ostream> &file) const {
+	if (outputStream)
+		return *outputStream;
+	file = openOutputFile(outputFile);
+	return *file;
+}
+
+
+void NullAnnotator::dumpRecords(const vector<const Function *> &functions, const IIGlueReader &iiglue) {
+	// one self-contained line per function, so readers can start early
+	const lock_guard<mutex> lock(recordsLock);
+	for (const Function &function : functions | indirected) {
+		*records << "{\"function\": ";
+		writeJSONString(*records, function.getName());
+		*records << ", ";
+		dumpFunction(*records, function, iiglue, "", ", ");
+		*records << "}\n";
+	}
+}
+
+
+void NullAnnotator::buildReachabilityIndex(const Function &func, ReachingArguments &reachingArguments) {
+	// look up each call operand once, finding all reaching arguments
+	// together rather than testing them one at a time
+	ReachabilityIndex &index = functionToOperandSources[&func];
+	for (const CallInst &call : functionToCallSites[&func] | indirected) {
+		if (call.getCalledFunction() == nullptr)
 			continue;
+		for (const unsigned argNo : irange(0u, call.getNumArgOperands())) {
+			const SmallBitVector &reaching = reachingArguments(*call.getArgOperand(argNo));
+			++operandLookups;
+			if (reaching.any())
+				index.push_back({ &call, argNo, reaching });
 		}
+	}
+	DEBUG(dbgs() << "We found " << index.size() << " call operands reached by arguments of " << func.getName() << '\n');
+}
+
 
-		const Function::ArgumentListType &arguments = function->getArgumentList();
-		const ptree &arg_annotations = framePair.second.get_child("argument_annotations");
-		if (arguments.size() != arg_annotations.size()) {
-			errs() << "Warning: Arity mismatch between function " << name
-			       << " in the .json file provided: " << filename
-			       << " and the one found in the bitcode. Skipping.\n";
+void NullAnnotator::addDependencies(const Function &func, const IIGlueReader &iiglue, ReachingArguments &reachingArguments) {
+	const TraceScope tracing("build dependencies", func.getName());
+	// collect calls in this function for scanning
+	const auto instructions =
+		make_iterator_range(inst_begin(func), inst_end(func))
+		| transformed([](const Instruction &inst) { return dyn_cast<CallInst>(&inst); })
+		| filtered(boost::lambda::_1);
+	functionToCallSites.emplace(&func, CallInstList(instructions.begin(), instructions.end()));
+	DEBUG(dbgs() << "went through all the instructions and grabbed calls\n");
+	DEBUG(dbgs() << "We found " << functionToCallSites[&func].size() << " calls in " << func.getName() << '\n');
+
+	// link each array argument to every callee parameter it may flow
+	// into, so that later changes only revisit affected arguments
+	for (const Argument &arg : iiglue.arrayArguments(func))
+		calleeParameters[&arg];
+
+	buildReachabilityIndex(func, reachingArguments);
+	vector<const Argument *> actuals;
+	for (const Argument &arg : func.getArgumentList())
+		actuals.push_back(&arg);
+
+	for (const OperandSources &sources : functionToOperandSources[&func]) {
+		// extra actuals passed to variadic callees have no parameter
+		const Function &calledFunction = *sources.call->getCalledFunction();
+		if (sources.operand >= calledFunction.arg_size())
 			continue;
+		const auto parameter = next(calledFunction.arg_begin(), sources.operand);
+
+		for (int argNo = sources.arguments.find_first(); argNo != -1; argNo = sources.arguments.find_next(argNo)) {
+			const Argument &arg = *actuals[argNo];
+			if (!iiglue.isArray(arg)) continue;
+			DEBUG(dbgs() << func.getName() << " argument " << argNo << " reaches "
+			      << calledFunction.getName() << " argument " << sources.operand << '\n');
+			calleeParameters[&arg].push_back(&*parameter);
+			dependentArguments[&*parameter].push_back(&arg);
+			++dependencyEdges;
 		}
-		for (const auto &slot : boost::combine(arguments, arg_annotations)) {
-			const Argument &argument = slot.get<0>();
-			const Answer annotation = static_cast<Answer>(slot.get<1>().second.get_value<int>());
-			annotations[&argument] = annotation;
+	}
+}
+
+
+void NullAnnotator::buildDependencyGraph(const IIGlueReader &iiglue, ReachingArguments &reachingArguments) {
+	for (const Function &func : iiglue.arrayReceivers())
+		addDependencies(func, iiglue, reachingArguments);
+}
+
+
+// returns true if arg has just become NULL_TERMINATED
+bool NullAnnotator::update(const Argument &arg, const FindSentinels::FunctionResults *functionChecks) {
+	++argumentVisits;
+	DEBUG(dbgs() << "\tConsidering " << arg.getArgNo() << "\n");
+	const Answer oldResult = getAnswer(arg);
+	DEBUG(dbgs() << "\tOld result: " << oldResult << '\n');
+	if (oldResult == NULL_TERMINATED)
+		return false;
+
+	// process evidence from callees
+	bool foundDontCare = false;
+	bool foundNonNullTerminated = false;
+	for (const Argument &parameter : calleeParameters.at(&arg) | indirected) {
+		switch (getAnswer(parameter)) {
+		case NULL_TERMINATED:
+			DEBUG(dbgs() << "Marking NULL_TERMINATED\n");
+			record(arg, NULL_TERMINATED, CalleeNullTerminated, parameter.getParent());
+			return true;
+
+		case NON_NULL_TERMINATED:
+			// maybe set/check a flag for error reporting
+			foundNonNullTerminated = true;
+			break;
+
+		case DONT_CARE:
+			// maybe set/check a flag for error reporting
+			if (foundNonNullTerminated) {
+				DEBUG(dbgs() << "Found both DONT_CARE and NON_NULL_TERMINATED among callees.\n");
+			}
+			foundDontCare = true;
+			break;
+
+		default:
+			// should never happen!
+			abort();
 		}
 	}
+
+	// if we haven't yet marked NULL_TERMINATED, might be NON_NULL_TERMINATED
+	const BasicBlock * const loop = oldResult == NON_NULL_TERMINATED ? nullptr : hasLoopWithSentinelCheck(functionChecks, arg);
+	if (loop) {
+		DEBUG(dbgs() << "Marking NOT_NULL_TERMINATED\n");
+		record(arg, NON_NULL_TERMINATED, SentinelCheck, loop);
+		if (foundDontCare) {
+			DEBUG(dbgs() << "Marking NOT_NULL_TERMINATED even though other calls say DONT_CARE.\n");
+			// do error reporting stuff
+		}
+	}
+
+	// otherwise it stays as DONT_CARE for now.
+	return false;
 }
 
 
-template<typename Detail> static
-void dumpArgumentDetails(ostream &out, const Function::ArgumentListType &argumentList, const char key[], const Detail &detail) {
-	out << "\t\t\t\"" << key << "\": [";
-	for (const Argument &argument : argumentList) {
-		if (&argument != argumentList.begin())
-			out << ", ";
-		out << detail(argument);
+void NullAnnotator::solveComponent(const vector<const Function *> &functions, unsigned component, const IIGlueReader &iiglue, const FindSentinels &findSentinels) {
+	const TraceScope tracing("solve component", functions.front()->getName());
+	deque<const Argument *> worklist;
+	unordered_set<const Argument *> queued;
+
+	// process loops exactly once, and queue everything else
+	for (const Function &func : functions | indirected) {
+		const FindSentinels::FunctionResults * const functionChecks = findSentinels.getResultsForFunction(&func);
+		for (const Argument &arg : iiglue.arrayArguments(func)) {
+			const BasicBlock * const loop = getAnswer(arg) == NULL_TERMINATED ? nullptr : existsNonOptionalSentinelCheck(functionChecks, arg);
+			if (loop) {
+				DEBUG(dbgs() << "\tFound a non-optional sentinel check in some loop!\n");
+				record(arg, NULL_TERMINATED, NonOptionalSentinelCheck, loop);
+			}
+			worklist.push_back(&arg);
+			queued.insert(&arg);
+		}
+	}
+
+	// callees outside this component are already final, so only
+	// callers within it can change once a parameter becomes NULL_TERMINATED;
+	// a round ends once everything queued before it has been visited
+	size_t roundRemaining = 0;
+	TraceScope round;
+	while (!worklist.empty()) {
+		if (roundRemaining == 0) {
+			++fixedPointRounds;
+			roundRemaining = worklist.size();
+			round.open("fixed-point round", functions.front()->getName());
+		}
+		--roundRemaining;
+		const Argument &arg = *worklist.front();
+		worklist.pop_front();
+		queued.erase(&arg);
+
+		if (!update(arg, findSentinels.getResultsForFunction(arg.getParent())))
+			continue;
+
+		const auto dependents = dependentArguments.find(&arg);
+		if (dependents == dependentArguments.end())
+			continue;
+		for (const Argument * const caller : dependents->second)
+			if (componentOf.at(caller->getParent()) == component
+			    && getAnswer(*caller) != NULL_TERMINATED
+			    && queued.insert(caller).second) {
+				worklist.push_back(caller);
+				++argumentRequeues;
+			}
 	}
-	out << ']';
 }
 
 
-void NullAnnotator::dumpToFile(const string &filename, const IIGlueReader &iiglue, const Module &module) const {
-	ofstream out(filename);
-	out << "{\n\t\"library_functions\": {\n";
-	for (const Function &function : module) {
+uint64_t NullAnnotator::componentKey(const vector<const Function *> &functions, unsigned component, const IIGlueReader &iiglue) const {
+	// everything the solver looks at: member code, which arguments are
+	// arrays, and the final answers of parameters outside the component
+	StructuralHash key;
+	for (const Function &func : functions | indirected) {
+		key << func.getName() << structuralHash(func);
+		for (const Argument &arg : func.getArgumentList())
+			key << iiglue.isArray(arg);
+		for (const Argument &arg : iiglue.arrayArguments(func))
+			for (const Argument &parameter : calleeParameters.at(&arg) | indirected) {
+				const Function &callee = *parameter.getParent();
+				const auto calleeComponent = componentOf.find(&callee);
+				if (calleeComponent != componentOf.end() && calleeComponent->second == component)
+					continue;
+				key << callee.getName() << parameter.getArgNo() << getAnswer(parameter);
+			}
+	}
+	return key.value();
+}
 
-		if (&function != module.begin())
-			out << ",\n";
 
-		out << "\t\t\"" << function.getName().str() << "\": {\n";
-		const Function::ArgumentListType &argumentList = function.getArgumentList();
+// returns false if the cached results do not fit these functions
+bool NullAnnotator::restoreComponent(const vector<const Function *> &functions, const IncrementalCache::Component &cached, const IIGlueReader &iiglue) {
+	if (cached.size() != functions.size())
+		return false;
+	// resolve each saved source name back to a callee or loop header
+	vector<vector<const Value *>> sources;
+	for (const auto &slot : boost::combine(functions, cached)) {
+		const Function &func = *slot.get<0>();
+		const IncrementalCache::Member &member = slot.get<1>();
+		if (member.name != func.getName() || member.answers.size() != func.arg_size())
+			return false;
+
+		sources.emplace_back();
+		for (const Argument &arg : iiglue.arrayArguments(func)) {
+			const unsigned argNo = arg.getArgNo();
+			const StringRef name = member.sources[argNo];
+			const Value *source = nullptr;
+			switch (member.reasons[argNo]) {
+			case NoReason:
+				break;
+			case CalleeNullTerminated:
+				source = func.getParent()->getFunction(name);
+				if (!source) return false;
+				break;
+			case SentinelCheck:
+			case NonOptionalSentinelCheck:
+				// unnamed blocks cannot be found again, but are only
+				// provenance: the reason text does not depend on them
+				if (!name.empty())
+					source = func.getValueSymbolTable().lookup(name);
+				break;
+			default:
+				return false;
+			}
+			sources.back().push_back(source);
+		}
+	}
 
-		dumpArgumentDetails(out, argumentList, "argument_names",
-				    [](const Argument &arg) {
-					    return '\"' + arg.getName().str() + '\"';
-				    }
-			);
-		out << ",\n";
+	auto functionSources = sources.begin();
+	for (const auto &slot : boost::combine(functions, cached)) {
+		const IncrementalCache::Member &member = slot.get<1>();
+		auto source = functionSources++->begin();
+		for (const Argument &arg : iiglue.arrayArguments(*slot.get<0>())) {
+			const unsigned argNo = arg.getArgNo();
+			record(arg, static_cast<Answer>(member.answers[argNo]), static_cast<ReasonCode>(member.reasons[argNo]), *source++);
+		}
+	}
+	return true;
+}
 
-		dumpArgumentDetails(out, argumentList, "argument_annotations",
-				    [&](const Argument &arg) {
-					    return getAnswer(arg);
-				    }
-			);
-		out << ",\n";
 
-		dumpArgumentDetails(out, argumentList, "args_array_receivers",
-				    [&](const Argument &arg) {
-					    return iiglue.isArray(arg);
-				    }
-			);
-		out << ",\n";
+IncrementalCache::Component NullAnnotator::saveComponent(const vector<const Function *> &functions) const {
+	IncrementalCache::Component saved;
+	for (const Function &func : functions | indirected) {
+		saved.push_back({ func.getName().str(), {}, {}, {} });
+		IncrementalCache::Member &member = saved.back();
+		for (const Argument &arg : func.getArgumentList()) {
+			const ArgumentResult &found = result(arg);
+			member.answers.push_back(found.answer);
+			member.reasons.push_back(found.reason.code);
+			member.sources.push_back(found.reason.source ? found.reason.source->getName().str() : string());
+		}
+	}
+	return saved;
+}
 
-		dumpArgumentDetails(out, argumentList, "argument_reasons",
-				    [&](const Argument &arg) {
-					    const auto reason = reasons.find(&arg);
-					    return '\"' + (reason == reasons.end() ? "" : reason->second) + '\"';
-				    }
-			);
 
-		out << "\n\t\t}";
+void NullAnnotator::solveIncrementally(const vector<const Function *> &functions, unsigned component, const IIGlueReader &iiglue, const FindSentinels &findSentinels) {
+	// callees are final by now, so their answers can go into the key
+	const TraceScope tracing("solve component incrementally", functions.front()->getName());
+	const uint64_t key = componentKey(functions, component, iiglue);
+	const auto cached = cache->find(key);
+	if (cached && restoreComponent(functions, *cached, iiglue)) {
+		++cacheHits;
+		++componentsReused;
+	} else {
+		++cacheMisses;
+		solveComponent(functions, component, iiglue, findSentinels);
 	}
-	out << "\n\t}\n}\n";
+	cache->record(key, saveComponent(functions));
+}
+
+
+// solves array receivers not yet final, given in module order; their
+// callees must be either among them or final already
+void NullAnnotator::solve(const vector<const Function *> &functions, const IIGlueReader &iiglue, const FindSentinels &findSentinels) {
+	unordered_map<const Function *, unsigned> functionIndex;
+	for (const unsigned index : irange<unsigned>(0, functions.size()))
+		functionIndex.emplace(functions[index], index);
+
+	// call graph among array receivers, as seen through argument flow
+	vector<vector<unsigned>> callees(functions.size());
+	for (const unsigned caller : irange<unsigned>(0, functions.size()))
+		for (const Argument &arg : iiglue.arrayArguments(*functions[caller])) {
+			for (const Argument &parameter : calleeParameters.at(&arg) | indirected) {
+				const auto callee = functionIndex.find(parameter.getParent());
+				if (callee != functionIndex.end())
+					callees[caller].push_back(callee->second);
+			}
+		}
+
+	// number components after those solved by earlier calls
+	const Components components = stronglyConnectedComponents(callees);
+	componentsSolved += components.size();
+	const unsigned first = componentCount;
+	componentCount += components.size();
+	for (const unsigned component : irange<unsigned>(0, components.size()))
+		for (const unsigned member : components[component])
+			componentOf.emplace(functions[member], first + component);
+
+	// each component waits for the distinct components it calls into
+	vector<vector<unsigned>> waiting(components.size());
+	vector<unsigned> pending(components.size());
+	for (const unsigned caller : irange<unsigned>(0, functions.size()))
+		for (const unsigned callee : callees[caller]) {
+			const unsigned callerComponent = componentOf.at(functions[caller]) - first;
+			const unsigned calleeComponent = componentOf.at(functions[callee]) - first;
+			if (callerComponent != calleeComponent)
+				waiting[calleeComponent].push_back(callerComponent);
+		}
+	for (vector<unsigned> &dependents : waiting) {
+		std::sort(dependents.begin(), dependents.end());
+		dependents.erase(std::unique(dependents.begin(), dependents.end()), dependents.end());
+		for (const unsigned dependent : dependents)
+			++pending[dependent];
+	}
+
+	parallelTopological(threadCount, waiting, std::move(pending), [&](unsigned component) {
+			vector<const Function *> members;
+			for (const unsigned member : components[component])
+				members.push_back(functions[member]);
+			if (cache)
+				solveIncrementally(members, first + component, iiglue, findSentinels);
+			else
+				solveComponent(members, first + component, iiglue, findSentinels);
+			if (records)
+				dumpRecords(members, iiglue);
+		});
+
+	measureMemory();
+}
+
+
+void NullAnnotator::measureMemory() const {
+	size_t resultBytes = heapBytes(results);
+	for (const auto &table : results)
+		resultBytes += heapBytes(table.second);
+	resultsHeld.observe(resultBytes);
+
+	size_t callSiteBytes = heapBytes(functionToCallSites);
+	for (const auto &calls : functionToCallSites)
+		callSiteBytes += heapBytes(calls.second);
+	callSitesHeld.observe(callSiteBytes);
+
+	size_t dependencyBytes = heapBytes(calleeParameters) + heapBytes(dependentArguments)
+		+ heapBytes(functionToOperandSources) + heapBytes(componentOf);
+	for (const auto &edges : calleeParameters)
+		dependencyBytes += heapBytes(edges.second);
+	for (const auto &edges : dependentArguments)
+		dependencyBytes += heapBytes(edges.second);
+	for (const auto &index : functionToOperandSources)
+		dependencyBytes += heapBytes(index.second);
+	dependenciesHeld.observe(dependencyBytes);
+}
+
+
+void NullAnnotator::solveDemanded(const vector<const Function *> &roots, const IIGlueReader &iiglue, const FindSentinels &findSentinels, ReachingArguments &reachingArguments) {
+	// find array receivers reachable from the roots that are not yet
+	// final, building their dependencies on first sight
+	unordered_set<const Function *> reached;
+	vector<const Function *> pending;
+	const auto reach = [&](const Function &func) {
+		if (!iiglue.isArrayReceiver(func) || componentOf.count(&func) || !reached.insert(&func).second)
+			return;
+		if (!functionToCallSites.count(&func))
+			addDependencies(func, iiglue, reachingArguments);
+		pending.push_back(&func);
+	};
+
+	for (const Function &root : roots | indirected)
+		reach(root);
+	while (!pending.empty()) {
+		const Function &func = *pending.back();
+		pending.pop_back();
+		for (const Argument &arg : iiglue.arrayArguments(func))
+			for (const Argument &parameter : calleeParameters.at(&arg) | indirected)
+				reach(*parameter.getParent());
+	}
+	if (reached.empty())
+		return;
+
+	// solve in module order, just as a whole-module run would
+	vector<const Function *> functions;
+	for (const Function &func : *roots.front()->getParent())
+		if (reached.count(&func))
+			functions.push_back(&func);
+	solve(functions, iiglue, findSentinels);
+}
+
+
+// just the queried functions that exist, if there are queries, so a
+// query naming nothing in this module reports nothing
+vector<const Function *> NullAnnotator::reportedFunctions(const Module &module) const {
+	if (!queryNames.empty())
+		return queried;
+	vector<const Function *> functions;
+	for (const Function &func : module)
+		functions.push_back(&func);
+	return functions;
 }
 
 
 bool NullAnnotator::runOnModule(Module &module) {
-	for (const string &dependency : dependencyFileNames) {
-		populateFromFile(dependency, module);
+	// make room for every result up front, so that concurrent solvers
+	// only ever update existing entries
+	for (const Function &func : module)
+		results[&func].assign(func.arg_size(), { DONT_CARE, { NoReason, nullptr } });
+
+	if (!dependencies) {
+		ownDependencies.reset(new Dependencies);
+		ownDependencies->readCommandLine();
+		dependencies = ownDependencies.get();
 	}
+	dependencies->apply(module, [&](const Function &function, ArrayRef<uint8_t> answers) {
+			auto answer = answers.begin();
+			for (const Argument &argument : function.getArgumentList())
+				result(argument).answer = static_cast<Answer>(*answer++);
+		});
 	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
+	const FindSentinels &findSentinels = getAnalysis<FindSentinels>();
+	ReachingArguments &reachingArguments = getAnalysis<ReachingArguments>();
 
-	// collect calls in each function for repeated scanning later
-	for (const Function &func : iiglue.arrayReceivers()) {
-		const auto instructions =
-			make_iterator_range(inst_begin(func), inst_end(func))
-			| transformed([](const Instruction &inst) { return dyn_cast<CallInst>(&inst); })
-			| filtered(boost::lambda::_1);
-		functionToCallSites.emplace(&func, CallInstSet(instructions.begin(), instructions.end()));
-		DEBUG(dbgs() << "went through all the instructions and grabbed calls\n");
-		DEBUG(dbgs() << "We found " << functionToCallSites[&func].size() << " calls in " << func.getName() << '\n');
+	for (const string &name : queryNames) {
+		const Function * const function = module.getFunction(name);
+		if (function)
+			queried.push_back(function);
+		else
+			errs() << "warning: queried function " << name << " not found in bitcode\n";
+	}
+	if (!queryNames.empty() && queried.empty())
+		errs() << "warning: no queried function found in bitcode; reporting nothing\n";
+
+	// functions without array arguments are already final, so stream
+	// them out before solving; the rest follow component by component
+	const bool writing = outputStream || !outputFile.empty();
+	const bool streaming = writing && outputFormat == OutputJSONLines && queryNames.empty();
+	unique_ptr<raw_fd_ostream> outputStorage;
+	if (streaming) {
+		records = &openOutput(outputStorage);
+		vector<const Function *> unchanging;
+		for (const Function &func : module)
+			if (!iiglue.isArrayReceiver(func))
+				unchanging.push_back(&func);
+		dumpRecords(unchanging, iiglue);
 	}
 
-	const FindSentinels &findSentinels = getAnalysis<FindSentinels>();
-	bool firstTime = true;
-	bool changed;
-
-	do {
-		changed = false;
-		for (const Function &func : iiglue.arrayReceivers()) {
-			DEBUG(dbgs() << "About to get the map for this function\n");
-			const FindSentinels::FunctionResults * const functionChecks = findSentinels.getResultsForFunction(&func);
-			for (const Argument &arg : iiglue.arrayArguments(func)) {
-				DEBUG(dbgs() << "\tConsidering " << arg.getArgNo() << "\n");
-				Answer oldResult = getAnswer(arg);
-				DEBUG(dbgs() << "\tOld result: " << oldResult << '\n');
-				if (oldResult == NULL_TERMINATED)
-					continue;
-				if (firstTime) {
-					// process loops exactly once
-					if (existsNonOptionalSentinelCheck(functionChecks, arg)) {
-						DEBUG(dbgs() << "\tFound a non-optional sentinel check in some loop!\n");
-						annotations[&arg] = NULL_TERMINATED;
-						reasons[&arg] = "Found a non-optional sentinel check in some loop of this function.";
-						changed = true;
-						continue;
-					}
-				}
-				// if we haven't yet continued, process evidence from callees.
-				bool foundDontCare = false;
-				bool foundNonNullTerminated = false;
-				bool nextArgumentPlease = false;
-				for (const CallInst &call : functionToCallSites[&func] | indirected) {
-					DEBUG(dbgs() << "About to iterate over the arguments to the call\n");
-					DEBUG(dbgs() << "Call: " << call.getName() << "\n");
-					DEBUG(dbgs() << "getCalledFunction name: " << call.getCalledFunction() << "\n");
-					const auto calledFunction = call.getCalledFunction();
-					if (calledFunction == nullptr)
-						continue;
-					const auto formals = calledFunction->getArgumentList().begin();
-					DEBUG(dbgs() << "Got formals\n");
-					for (const unsigned argNo : irange(0u, call.getNumArgOperands())) {
-						DEBUG(dbgs() << "Starting iteration\n");
-						const Value &actual = *call.getArgOperand(argNo);
-						if (!argumentReachesValue(arg, actual)) continue;
-						DEBUG(dbgs() << "Name of arg: " << arg.getName() << "\n");
-						DEBUG(dbgs() << "hey, it matches!\n");
-
-						auto parameter = next(formals, argNo);
-						if (parameter == calledFunction->getArgumentList().end() || argNo != parameter->getArgNo()) {
-							continue;
-						}
-						DEBUG(dbgs() << "About to enter the switch\n");
-						switch (getAnswer(*parameter)) {
-						case NULL_TERMINATED:
-							DEBUG(dbgs() << "Marking NULL_TERMINATED\n");
-							annotations[&arg] = NULL_TERMINATED;
-							reasons[&arg] = "Called " + calledFunction->getName().str() + ", marked as null terminated in this position";
-							changed = true;
-							nextArgumentPlease = true;
-							break;
-
-						case NON_NULL_TERMINATED:
-							// maybe set/check a flag for error reporting
-							foundNonNullTerminated = true;
-							break;
-
-						case DONT_CARE:
-							// maybe set/check a flag for error reporting
-							if (foundNonNullTerminated) {
-								DEBUG(dbgs() << "Found both DONT_CARE and NON_NULL_TERMINATED among callees.\n");
-							}
-							foundDontCare = true;
-							break;
-
-						default:
-							// should never happen!
-							abort();
-						}
-					}
-
-					if (nextArgumentPlease) {
-						break;
-					}
-				}
-				if (nextArgumentPlease) {
-					continue;
-				}
-				// if we haven't yet marked NULL_TERMINATED, might be NON_NULL_TERMINATED
-				if (hasLoopWithSentinelCheck(functionChecks, arg)) {
-					if (oldResult != NON_NULL_TERMINATED) {
-						DEBUG(dbgs() << "Marking NOT_NULL_TERMINATED\n");
-						annotations[&arg] = NON_NULL_TERMINATED;
-						reasons[&arg] = "Has a loop with an optional sentinel check";
-						changed = true;
-						if (foundDontCare) {
-							DEBUG(dbgs() << "Marking NOT_NULL_TERMINATED even though other calls say DONT_CARE.\n");
-							// do error reporting stuff
-						}
-						continue;
-					}
-				}
-				// otherwise it stays as DONT_CARE for now.
-			}
+	if (!cache && !cacheFileName.empty()) {
+		ownCache.reset(new IncrementalCache(cacheFileName));
+		cache = ownCache.get();
+	}
+
+	if (queryNames.empty()) {
+		// number array receivers in module order for reproducible results
+		buildDependencyGraph(iiglue, reachingArguments);
+		vector<const Function *> functions;
+		for (const Function &func : module)
+			if (functionToCallSites.count(&func))
+				functions.push_back(&func);
+		solve(functions, iiglue, findSentinels);
+	} else
+		// queries take the same lazy path as drivers asking afterward
+		for (const Function &func : queried | indirected)
+			for (const Argument &arg : iiglue.arrayArguments(func))
+				getAnswer(func, arg.getArgNo());
+
+	if (ownCache) {
+		ownCache->save();
+		const unsigned hits = cacheHits, total = hits + cacheMisses;
+		errs() << "reused " << hits << " of " << total << " call graph components from "
+		       << cacheFileName << " (" << (total ? 100 * hits / total : 100) << "% hit rate)\n";
+	}
+
+	if (streaming) {
+		records = nullptr;
+		outputStorage.reset();
+	} else if (writing) {
+		const TraceScope tracing("write results", outputFile);
+		const vector<const Function *> reported = reportedFunctions(module);
+		raw_ostream &out = openOutput(outputStorage);
+		switch (outputFormat) {
+		case OutputJSON:
+			dumpJSON(out, iiglue, reported);
+			break;
+		case OutputJSONLines:
+			records = &out;
+			dumpRecords(reported, iiglue);
+			records = nullptr;
+			break;
+		case OutputSummary:
+			dumpSummary(out, reported);
+			break;
 		}
-		firstTime = false;
-	} while (changed);
-	if (!outputFileName.empty())
-		dumpToFile(outputFileName, iiglue, module);
+		outputStorage.reset();
+	}
+
+	if (summaries)
+		*summaries = summarize(reportedFunctions(module));
 	return false;
 }
 
 
 void NullAnnotator::print(raw_ostream &sink, const Module *module) const {
 	const IIGlueReader &iiglue = getAnalysis<IIGlueReader>();
-	for (const Function &func : *module) {
+	const vector<const Function *> reported = reportedFunctions(*module);
+	for (const Function &func : reported | indirected) {
 		for (const Argument &arg : iiglue.arrayArguments(func))
 			if (annotate(arg))
 				sink << func.getName() << " with argument " << arg.getArgNo()
@@ -0,0 +1,66 @@
+#ifndef INCLUDE_NULL_ANNOTATOR_HH
+#define INCLUDE_NULL_ANNOTATOR_HH
+
+#include "Answer.hh"
+#include "SummaryFile.hh"
+
+#include <string>
+#include <vector>
+
+class Dependencies;
+class IncrementalCache;
+
+namespace llvm {
+	class Function;
+	class ModulePass;
+	class raw_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  NullAnnotator for drivers that run it on many modules: dependency
+//  results are shared rather than read from "-dependency" files, and
+//  results go to the given stream rather than the "-output" file, if
+//  the stream is not null; drivers open output files themselves, so
+//  that failing to do so never throws from inside a pass
+//
+//  If summaries is not null, final results are also stored there, in
+//  the form Dependencies::add() takes, so that dependent modules can
+//  use them without a round trip through a file.
+//
+
+llvm::ModulePass *createNullAnnotator(const Dependencies &, llvm::raw_ostream *output, std::vector<SummaryFile::Summary> *summaries = nullptr);
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  NullAnnotator for long-running servers: results go to the given
+//  stream in the "-output-format" format, and call graph components
+//  are reused through the given cache, which outlives the pass and is
+//  never saved by it
+//
+//  If queries names any functions, only those that exist and the
+//  functions they transitively call are solved, and only those that
+//  exist are reported, as with "-null-annotator-query".  This is the
+//  demand-driven entry point for interactive clients such as editors.
+//
+
+llvm::ModulePass *createNullAnnotator(const Dependencies &, llvm::raw_ostream &output, IncrementalCache *, std::vector<std::string> queries = std::vector<std::string>());
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  final answer for one argument from a NullAnnotator made above, once
+//  its pass manager has run it on the function's module and for as
+//  long as that pass manager exists
+//
+//  A function left out by queries is solved on first demand, along
+//  with the functions it transitively calls; answers are memoized in
+//  the pass, so asking again is just a lookup.  Not thread safe.
+//
+
+Answer getNullAnnotatorAnswer(llvm::ModulePass &annotator, const llvm::Function &, unsigned argument);
+
+
+#endif // !INCLUDE_NULL_ANNOTATOR_HH
@@ -10,11 +10,29 @@ false negatives, and also doesn't always annotate as null-terminated things whic
 inferable as null-terminated because they are passed into a function as a varargs parameter.
 When I have a way to reason about varargs parameters, hopefully this will be resolved.
 '''
+
+def load(filename):
+	'''Load NullAnnotator results written in either output format.'''
+	text = open(filename).read()
+	try:
+		results = json.loads(text)
+	except ValueError:
+		results = None
+	if isinstance(results, dict) and 'library_functions' in results:
+		return results
+
+	# -output-format=jsonl: one record per line, which is also valid
+	# JSON when there is exactly one record
+	functions = {}
+	for line in text.splitlines():
+		if line.strip():
+			record = json.loads(line)
+			functions[record.pop('function')] = record
+	return {'library_functions': functions}
+
 if __name__ == '__main__':
-	output_data=open(sys.argv[1])
-	answer_data=open(sys.argv[2])
-	output = json.load(output_data)
-	answers = json.load(answer_data)
+	output = load(sys.argv[1])
+	answers = load(sys.argv[2])
 	outputLibraryFunctions = output['library_functions']
 	answerLibraryFunctions = answers['library_functions']
 
@@ -0,0 +1,22 @@
+#include "OutputFile.hh"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <llvm/Support/raw_ostream.h>
+#include <system_error>
+
+using namespace llvm;
+using namespace std;
+
+
+unique_ptr<raw_fd_ostream> openOutputFile(const string &filename) {
+	// open descriptor ourselves: this raw_fd_ostream constructor is
+	// the same across every LLVM version we support
+	const int descriptor = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (descriptor < 0)
+		throw system_error(errno, system_category(), "cannot write " + filename);
+
+	unique_ptr<raw_fd_ostream> stream(new raw_fd_ostream(descriptor, true));
+	stream->SetBufferSize(1 << 20);
+	return stream;
+}
@@ -0,0 +1,22 @@
+#ifndef INCLUDE_OUTPUT_FILE_HH
+#define INCLUDE_OUTPUT_FILE_HH
+
+#include <memory>
+#include <string>
+
+namespace llvm {
+	class raw_fd_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  create or truncate a file for writing through a large buffer
+//
+//  Throws std::system_error if the file cannot be created.
+//
+
+std::unique_ptr<llvm::raw_fd_ostream> openOutputFile(const std::string &filename);
+
+
+#endif // !INCLUDE_OUTPUT_FILE_HH
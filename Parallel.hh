@@ -0,0 +1,132 @@
+#ifndef INCLUDE_PARALLEL_HH
+#define INCLUDE_PARALLEL_HH
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  run independent units of work on a small pool of worker threads
+//
+//  With one thread, everything runs on the calling thread in a fixed
+//  order, so single-threaded runs stay exactly reproducible.
+//
+//  If the body throws, no further work starts; once every thread has
+//  stopped, the first exception thrown is rethrown to the caller.
+//
+
+// call body(0) through body(count - 1) using up to the given number
+// of threads; the calling thread participates as one of them
+template <typename Body>
+void parallelFor(unsigned threads, size_t count, const Body &body) {
+	if (threads <= 1 || count <= 1) {
+		for (size_t item = 0; item < count; ++item)
+			body(item);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	std::mutex failureLock;
+	std::exception_ptr failure;
+	const auto work = [&]() {
+		try {
+			for (size_t item; (item = next++) < count; )
+				body(item);
+		} catch (...) {
+			// items already started still finish
+			next = count;
+			const std::lock_guard<std::mutex> lock(failureLock);
+			if (!failure)
+				failure = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	const size_t helpers = std::min<size_t>(threads, count) - 1;
+	for (size_t helper = 0; helper < helpers; ++helper)
+		workers.emplace_back(work);
+	work();
+	for (std::thread &worker : workers)
+		worker.join();
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+
+// call body(node) for each node of a DAG, but only once every node
+// it waits for has finished; dependents[node] lists the nodes waiting
+// for node, and pending[node] counts how many nodes node waits for
+template <typename Body>
+void parallelTopological(unsigned threads, const std::vector<std::vector<unsigned>> &dependents, std::vector<unsigned> pending, const Body &body) {
+	const size_t total = dependents.size();
+	std::deque<unsigned> ready;
+	for (unsigned node = 0; node < total; ++node)
+		if (pending[node] == 0)
+			ready.push_back(node);
+
+	if (threads <= 1) {
+		while (!ready.empty()) {
+			const unsigned node = ready.front();
+			ready.pop_front();
+			body(node);
+			for (const unsigned dependent : dependents[node])
+				if (--pending[dependent] == 0)
+					ready.push_back(dependent);
+		}
+		return;
+	}
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	size_t finished = 0;
+	std::exception_ptr failure;
+
+	const auto work = [&]() {
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			changed.wait(lock, [&]() { return !ready.empty() || finished == total || failure; });
+			// nodes waiting on a failed one would never become ready
+			if (failure || ready.empty()) return;
+			const unsigned node = ready.front();
+			ready.pop_front();
+
+			lock.unlock();
+			try {
+				body(node);
+			} catch (...) {
+				lock.lock();
+				if (!failure)
+					failure = std::current_exception();
+				changed.notify_all();
+				return;
+			}
+			lock.lock();
+
+			++finished;
+			for (const unsigned dependent : dependents[node])
+				if (--pending[dependent] == 0)
+					ready.push_back(dependent);
+			changed.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	const size_t helpers = std::min<size_t>(threads, std::max<size_t>(total, 1)) - 1;
+	for (size_t helper = 0; helper < helpers; ++helper)
+		workers.emplace_back(work);
+	work();
+	for (std::thread &worker : workers)
+		worker.join();
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+
+#endif // !INCLUDE_PARALLEL_HH
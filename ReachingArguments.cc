@@ -0,0 +1,173 @@
+#include "Counters.hh"
+#include "ReachingArguments.hh"
+#include "StronglyConnected.hh"
+#include "Trace.hh"
+
+#include <boost/range/iterator_range_core.hpp>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace boost;
+using namespace llvm;
+using namespace std;
+
+
+static Counter queriesHit("reaching-arguments", "cache-hits");
+static Counter queriesMissed("reaching-arguments", "cache-misses");
+static Counter phiWebs("reaching-arguments", "phi-backtracks");
+static Counter phiNodesVisited("reaching-arguments", "phi-nodes-backtracked");
+static Counter phiComponents("reaching-arguments", "phi-components");
+static MemoryGauge cachesHeld("reaching-arguments", "caches");
+
+
+static const RegisterPass<ReachingArguments> registration("reaching-arguments",
+		"Find the formal arguments that may flow into each value across phi nodes",
+		true, true);
+
+char ReachingArguments::ID;
+
+static cl::opt<bool>
+	eager("reaching-arguments-eager",
+		cl::desc("Backtrack from every phi node up front rather than on demand, e.g. to time this pass on its own"));
+
+
+ReachingArguments::ReachingArguments()
+	: ModulePass(ID),
+	  hitCount(0),
+	  missCount(0),
+	  cacheBytes(0) {
+}
+
+
+void ReachingArguments::getAnalysisUsage(AnalysisUsage &usage) const {
+	// read-only pass never changes anything
+	usage.setPreservesAll();
+}
+
+
+bool ReachingArguments::runOnModule(Module &module) {
+	// all work normally happens lazily, as clients ask about specific values
+	if (eager)
+		for (const Function &function : module)
+			for (const BasicBlock &block : function)
+				for (const Instruction &instruction : block) {
+					// phi nodes always come first in their block
+					const PHINode * const phi = dyn_cast<PHINode>(&instruction);
+					if (!phi) break;
+					(*this)(*phi);
+				}
+	return false;
+}
+
+
+void ReachingArguments::releaseMemory() {
+	caches.clear();
+	cacheBytes = 0;
+}
+
+
+const SmallBitVector &ReachingArguments::operator()(const Value &value) {
+	const Argument * const argument = dyn_cast<Argument>(&value);
+	const PHINode * const phi = dyn_cast<PHINode>(&value);
+	if (!argument && !phi)
+		return none;
+
+	const Function &function = argument ? *argument->getParent() : *phi->getParent()->getParent();
+	// references to elements survive rehashing, so only finding or
+	// creating this function's cache needs the lock
+	FunctionCache &cache = [&]() -> FunctionCache & {
+		const lock_guard<mutex> lock(cachesLock);
+		return caches[&function];
+	}();
+	const auto found = cache.slots.find(&value);
+	if (found != cache.slots.end()) {
+		++hitCount;
+		++queriesHit;
+		return cache.results[found->second];
+	}
+
+	++missCount;
+	++queriesMissed;
+	const size_t slotsBytes = cache.slots.getMemorySize();
+	const size_t resultsCount = cache.results.size();
+	if (argument) {
+		SmallBitVector self(function.arg_size());
+		self.set(argument->getArgNo());
+		cache.slots[argument] = cache.results.size();
+		cache.results.push_back(std::move(self));
+	} else
+		fill(cache, *phi);
+	cachesHeld.observe(cacheBytes += cache.slots.getMemorySize() - slotsBytes + (cache.results.size() - resultsCount) * sizeof(SmallBitVector));
+
+	return cache.results[cache.slots[&value]];
+}
+
+
+void ReachingArguments::fill(FunctionCache &cache, const PHINode &start) {
+	const Function &function = *start.getParent()->getParent();
+	const TraceScope tracing("backtrack phi nodes", function.getName());
+	const unsigned arity = function.arg_size();
+
+	// number phi nodes in the not-yet-cached web behind start, noting
+	// which arguments and already-cached values feed each one directly
+	DenseMap<const PHINode *, unsigned> numbering;
+	vector<const PHINode *> nodes;
+	vector<vector<unsigned>> edges;
+	vector<SmallBitVector> direct;
+	const auto number = [&](const PHINode &phi) -> unsigned {
+		const auto inserted = numbering.insert(make_pair(&phi, nodes.size()));
+		if (inserted.second) {
+			nodes.push_back(&phi);
+			edges.emplace_back();
+			direct.emplace_back(arity);
+		}
+		return inserted.first->second;
+	};
+
+	++phiWebs;
+	number(start);
+	for (unsigned node = 0; node < nodes.size(); ++node) {
+		const auto operands = make_iterator_range(nodes[node]->op_begin(), nodes[node]->op_end());
+		for (const Use &operand : operands) {
+			const Value &value = *operand;
+			const auto cached = cache.slots.find(&value);
+			if (cached != cache.slots.end())
+				direct[node] |= cache.results[cached->second];
+			else if (const Argument * const argument = dyn_cast<Argument>(&value))
+				direct[node].set(argument->getArgNo());
+			else if (const PHINode * const phi = dyn_cast<PHINode>(&value)) {
+				const unsigned successor = number(*phi);
+				edges[node].push_back(successor);
+			}
+		}
+	}
+
+	// components arrive with everything they depend on already cached;
+	// all members of a component share a single result slot
+	phiNodesVisited += nodes.size();
+	for (const vector<unsigned> &component : stronglyConnectedComponents(edges)) {
+		++phiComponents;
+		SmallBitVector result(arity);
+		for (const unsigned member : component) {
+			result |= direct[member];
+			for (const unsigned successor : edges[member]) {
+				const auto solved = cache.slots.find(nodes[successor]);
+				if (solved != cache.slots.end())
+					result |= cache.results[solved->second];
+			}
+		}
+
+		const unsigned slot = cache.results.size();
+		cache.results.push_back(std::move(result));
+		for (const unsigned member : component)
+			cache.slots[nodes[member]] = slot;
+	}
+}
+
+
+void ReachingArguments::print(raw_ostream &sink, const Module *) const {
+	sink << "\treaching argument cache: " << hits() << " hits, " << misses() << " misses\n";
+}
@@ -0,0 +1,84 @@
+#ifndef INCLUDE_REACHING_ARGUMENTS_HH
+#define INCLUDE_REACHING_ARGUMENTS_HH
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallBitVector.h>
+#include <llvm/Pass.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace llvm {
+	class Function;
+	class PHINode;
+	class Value;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  memoized map from each value to the formal arguments of its
+//  function that may flow into it across zero or more phi nodes
+//
+//  Results are computed on demand, one function at a time.  On a miss,
+//  the whole uncached phi web behind the value is solved at once by
+//  collapsing its cycles into strongly connected components, so every
+//  phi node in that web becomes a hit for later queries.
+//
+//  Queries about different functions may run concurrently, but each
+//  function's values must be queried from only one thread at a time.
+//
+
+class ReachingArguments : public llvm::ModulePass {
+public:
+	// standard LLVM pass interface
+	ReachingArguments();
+	static char ID;
+	void getAnalysisUsage(llvm::AnalysisUsage &) const final override;
+	bool runOnModule(llvm::Module &) final override;
+	void releaseMemory() final override;
+	void print(llvm::raw_ostream &, const llvm::Module *) const final override;
+
+	// arguments reaching a value as a bit vector indexed by argument
+	// position; empty if the value is neither an argument nor a phi node
+	const llvm::SmallBitVector &operator()(const llvm::Value &);
+
+	// cache effectiveness so far
+	unsigned hits() const;
+	unsigned misses() const;
+
+private:
+	struct FunctionCache {
+		llvm::DenseMap<const llvm::Value *, unsigned> slots;
+		std::deque<llvm::SmallBitVector> results;
+	};
+
+	std::unordered_map<const llvm::Function *, FunctionCache> caches;
+	std::mutex cachesLock;
+	const llvm::SmallBitVector none;
+	std::atomic<unsigned> hitCount;
+	std::atomic<unsigned> missCount;
+	// heap bytes held by this instance's caches, for the memory gauge
+	std::atomic<uint64_t> cacheBytes;
+
+	void fill(FunctionCache &, const llvm::PHINode &);
+};
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline unsigned ReachingArguments::hits() const {
+	return hitCount;
+}
+
+
+inline unsigned ReachingArguments::misses() const {
+	return missCount;
+}
+
+
+#endif // !INCLUDE_REACHING_ARGUMENTS_HH
@@ -0,0 +1,19 @@
+#include "Reason.hh"
+
+using namespace llvm;
+using namespace std;
+
+
+string describeReason(ReasonCode code, StringRef callee) {
+	switch (code) {
+	case NoReason:
+		break;
+	case CalleeNullTerminated:
+		return "Called " + callee.str() + ", marked as null terminated in this position";
+	case SentinelCheck:
+		return "Has a loop with an optional sentinel check";
+	case NonOptionalSentinelCheck:
+		return "Found a non-optional sentinel check in some loop of this function.";
+	}
+	return string();
+}
@@ -0,0 +1,31 @@
+#ifndef INCLUDE_REASON_HH
+#define INCLUDE_REASON_HH
+
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  why an argument has its annotation, as reported in the
+//  "argument_reasons" of NullAnnotator and solve-summaries results
+//
+//  Codes are stored in incremental cache files, so only ever append.
+//
+
+enum ReasonCode : uint8_t {
+	NoReason,
+	CalleeNullTerminated,
+	SentinelCheck,
+	NonOptionalSentinelCheck
+};
+
+
+// the text for a reason; callee names the function justifying
+// CalleeNullTerminated and is otherwise ignored
+std::string describeReason(ReasonCode, llvm::StringRef callee);
+
+
+#endif // !INCLUDE_REASON_HH
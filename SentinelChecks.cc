@@ -0,0 +1,87 @@
+#include "SentinelChecks.hh"
+
+#include <cassert>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/IR/Function.h>
+
+using namespace llvm;
+using namespace std;
+
+
+const unsigned SentinelChecks::untracked;
+const uint32_t SentinelChecks::none;
+
+
+SentinelChecks::SentinelChecks(const Function &function, ArrayRef<const Argument *> arrayArguments)
+	: slots(function.arg_size(), untracked),
+	  width(arrayArguments.size()),
+	  summaries(arrayArguments.size(), Summary{ none, none }) {
+	for (unsigned slot = 0; slot < width; ++slot) {
+		assert(arrayArguments[slot]->getParent() == &function);
+		slots[arrayArguments[slot]->getArgNo()] = slot;
+	}
+}
+
+
+void SentinelChecks::addLoop(const BasicBlock &header, ArrayRef<BlockList> checks, const BitVector &optional) {
+	assert(checks.size() == width);
+	assert(optional.size() == width);
+	const uint32_t loop = headers.size();
+	headers.push_back(&header);
+
+	for (unsigned slot = 0; slot < width; ++slot) {
+		const Cell cell = { uint32_t(checkBlocks.size()), uint32_t(checks[slot].size()), optional.test(slot) };
+		cells.push_back(cell);
+		checkBlocks.insert(checkBlocks.end(), checks[slot].begin(), checks[slot].end());
+
+		Summary &summary = summaries[slot];
+		if (!checks[slot].empty() && summary.checkedLoop == none)
+			summary.checkedLoop = loop;
+		if (!optional.test(slot) && summary.nonOptionalLoop == none)
+			summary.nonOptionalLoop = loop;
+	}
+}
+
+
+const SentinelChecks::Cell &SentinelChecks::cell(unsigned loop, const Argument &arg) const {
+	const unsigned slot = slots[arg.getArgNo()];
+	assert(slot != untracked);
+	return cells[loop * width + slot];
+}
+
+
+SentinelChecks::Blocks SentinelChecks::checks(unsigned loop, const Argument &arg) const {
+	const Cell &found = cell(loop, arg);
+	return Blocks(checkBlocks.data() + found.firstCheck, found.checkCount);
+}
+
+
+bool SentinelChecks::optional(unsigned loop, const Argument &arg) const {
+	return cell(loop, arg).optional;
+}
+
+
+const BasicBlock *SentinelChecks::headerOf(uint32_t loop) const {
+	return loop == none ? nullptr : headers[loop];
+}
+
+
+const BasicBlock *SentinelChecks::loopWithSentinelCheck(const Argument &arg) const {
+	const unsigned slot = slots[arg.getArgNo()];
+	return slot == untracked ? nullptr : headerOf(summaries[slot].checkedLoop);
+}
+
+
+const BasicBlock *SentinelChecks::loopWithNonOptionalSentinelCheck(const Argument &arg) const {
+	const unsigned slot = slots[arg.getArgNo()];
+	return slot == untracked ? nullptr : headerOf(summaries[slot].nonOptionalLoop);
+}
+
+
+size_t SentinelChecks::memoryFootprint() const {
+	return slots.capacity() * sizeof(slots[0])
+		+ headers.capacity() * sizeof(headers[0])
+		+ cells.capacity() * sizeof(cells[0])
+		+ checkBlocks.capacity() * sizeof(checkBlocks[0])
+		+ summaries.capacity() * sizeof(summaries[0]);
+}
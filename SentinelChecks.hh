@@ -0,0 +1,100 @@
+#ifndef INCLUDE_SENTINEL_CHECKS_HH
+#define INCLUDE_SENTINEL_CHECKS_HH
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+	class Argument;
+	class BasicBlock;
+	class BitVector;
+	class Function;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  sentinel checks found in the loops of one function
+//
+//  Loops and array arguments are numbered densely.  Each (loop,
+//  argument) cell names a run of blocks within a single packed array of
+//  check blocks for the whole function.  Per-argument summaries are
+//  kept current as loops are added, so the questions NullAnnotator
+//  asks about each argument take constant time.
+//
+
+class SentinelChecks {
+public:
+	typedef llvm::ArrayRef<const llvm::BasicBlock *> Blocks;
+	typedef llvm::SmallVector<const llvm::BasicBlock *, 2> BlockList;
+
+	// track the given array arguments of a function, in the order
+	// their checks will later be given to addLoop()
+	SentinelChecks(const llvm::Function &, llvm::ArrayRef<const llvm::Argument *> arrayArguments);
+
+	// record one loop: checks[k] lists the sentinel checks of array
+	// argument k, and optional[k] is set if all can be bypassed
+	void addLoop(const llvm::BasicBlock &header, llvm::ArrayRef<BlockList> checks, const llvm::BitVector &optional);
+
+	// loops in the order they were added
+	unsigned loopCount() const;
+	const llvm::BasicBlock &header(unsigned loop) const;
+
+	// results for one array argument in one loop
+	Blocks checks(unsigned loop, const llvm::Argument &) const;
+	bool optional(unsigned loop, const llvm::Argument &) const;
+
+	// summaries for one array argument across all loops: the header
+	// of the first loop found with such checks, or null if none
+	const llvm::BasicBlock *loopWithSentinelCheck(const llvm::Argument &) const;
+	const llvm::BasicBlock *loopWithNonOptionalSentinelCheck(const llvm::Argument &) const;
+
+	// heap memory held by these results
+	size_t memoryFootprint() const;
+
+private:
+	struct Cell {
+		uint32_t firstCheck;
+		uint32_t checkCount;
+		bool optional;
+	};
+
+	struct Summary {
+		uint32_t checkedLoop;
+		uint32_t nonOptionalLoop;
+	};
+
+	// dense argument number for each formal argument, or untracked;
+	// summaries use none for loop numbers not yet found
+	static const unsigned untracked = ~0u;
+	static const uint32_t none = ~0u;
+	std::vector<unsigned> slots;
+	const unsigned width;
+
+	std::vector<const llvm::BasicBlock *> headers;
+	std::vector<Cell> cells;
+	std::vector<const llvm::BasicBlock *> checkBlocks;
+	std::vector<Summary> summaries;
+
+	const Cell &cell(unsigned loop, const llvm::Argument &) const;
+	const llvm::BasicBlock *headerOf(uint32_t loop) const;
+};
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline unsigned SentinelChecks::loopCount() const {
+	return headers.size();
+}
+
+
+inline const llvm::BasicBlock &SentinelChecks::header(unsigned loop) const {
+	return *headers[loop];
+}
+
+
+#endif // !INCLUDE_SENTINEL_CHECKS_HH
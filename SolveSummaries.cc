@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////
+//
+//  phase two of two-phase analysis: derive NullAnnotator results for
+//  a whole program from the local summaries of its modules, as written
+//  by the "-local-summaries" pass, without loading any bitcode
+//
+//  A call from one module resolves to a function of that same module
+//  if it has one by that name, and otherwise to the one non-local
+//  function of that name in any module.  Callees found nowhere take
+//  their answers from "-dependency" files, as in a single-module run.
+//
+
+#include "Answer.hh"
+#include "Dependencies.hh"
+#include "JSONWriter.hh"
+#include "LocalSummaryFile.hh"
+#include "OutputFile.hh"
+#include "Parallel.hh"
+#include "Reason.hh"
+#include "Trace.hh"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+static cl::list<string>
+	summaryFileNames(cl::Positional,
+		cl::OneOrMore,
+		cl::value_desc("summaries"),
+		cl::desc("<local summaries>..."));
+
+static cl::opt<string>
+	outputFileName("output",
+		cl::Required,
+		cl::value_desc("filename"),
+		cl::desc("Filename to write results to, in NullAnnotator's JSON format"));
+
+static cl::opt<unsigned>
+	threadCount("jobs",
+		cl::init(1),
+		cl::value_desc("count"),
+		cl::desc("Number of threads used to read local summaries"));
+
+
+namespace {
+	class Solver {
+	public:
+		explicit Solver(vector<ModuleSummary>, const Dependencies &);
+		void solve();
+		void write(raw_ostream &) const;
+
+	private:
+		struct ArgumentResult {
+			Answer answer;
+			ReasonCode reason;
+			// callee justifying CalleeNullTerminated
+			const string *callee;
+		};
+
+		const vector<ModuleSummary> modules;
+		const Dependencies &dependencies;
+
+		// every function of every module, and the first slot of each
+		// one's arguments in results
+		vector<const LocalSummary *> functions;
+		vector<unsigned> firstArgument;
+		vector<ArgumentResult> results;
+
+		// argument slots reached by each slot, in reverse call direction
+		vector<vector<unsigned>> dependentArguments;
+
+		void resolveCalls(vector<unsigned> &newlyNullTerminated);
+	};
+}
+
+
+Solver::Solver(vector<ModuleSummary> modules, const Dependencies &dependencies)
+	: modules(std::move(modules)),
+	  dependencies(dependencies) {
+	for (const ModuleSummary &module : this->modules)
+		for (const LocalSummary &function : module.functions) {
+			functions.push_back(&function);
+			firstArgument.push_back(results.size());
+			results.resize(results.size() + function.arrays.size(), { DONT_CARE, NoReason, nullptr });
+		}
+	dependentArguments.resize(results.size());
+}
+
+
+void Solver::resolveCalls(vector<unsigned> &newlyNullTerminated) {
+	const TraceScope tracing("resolve calls");
+
+	// non-local functions by name, program-wide
+	StringMap<unsigned> global;
+	for (unsigned index = 0; index < functions.size(); ++index) {
+		const LocalSummary &function = *functions[index];
+		if (!function.local && !global.insert({ function.name, index }).second)
+			errs() << "warning: function " << function.name << " defined more than once; using the first definition\n";
+	}
+
+	unsigned index = 0;
+	for (const ModuleSummary &module : modules) {
+		StringMap<unsigned> own;
+		for (unsigned member = 0; member < module.functions.size(); ++member)
+			own.insert({ module.functions[member].name, index + member });
+		const auto resolve = [&](StringRef name, unsigned &callee) {
+			auto found = own.find(name);
+			if (found != own.end()) {
+				callee = found->second;
+				return true;
+			}
+			found = global.find(name);
+			if (found != global.end()) {
+				callee = found->second;
+				return true;
+			}
+			return false;
+		};
+
+		for (const LocalSummary &caller : module.functions) {
+			for (const LocalSummary::Call &call : caller.calls) {
+				const unsigned argument = firstArgument[index] + call.argument;
+				unsigned callee;
+				if (resolve(call.callee, callee)) {
+					if (functions[callee]->arrays.size() == call.arity)
+						dependentArguments[firstArgument[callee] + call.parameter].push_back(argument);
+					else
+						errs() << "warning: function " << call.callee << " called with " << call.arity
+						       << " parameters from " << caller.name << " but defined with "
+						       << functions[callee]->arrays.size() << '\n';
+					continue;
+				}
+
+				// callees outside the program are final from the start
+				ArrayRef<uint8_t> answers;
+				if (results[argument].answer != NULL_TERMINATED
+				    && dependencies.lookup(call.callee, call.arity, answers)
+				    && answers[call.parameter] == NULL_TERMINATED) {
+					results[argument] = { NULL_TERMINATED, CalleeNullTerminated, &call.callee };
+					newlyNullTerminated.push_back(argument);
+				}
+			}
+			++index;
+		}
+	}
+}
+
+
+void Solver::solve() {
+	// seed every function with any dependency results for it
+	for (unsigned index = 0; index < functions.size(); ++index) {
+		const LocalSummary &function = *functions[index];
+		ArrayRef<uint8_t> answers;
+		if (dependencies.lookup(function.name, function.arrays.size(), answers))
+			for (unsigned argNo = 0; argNo < answers.size(); ++argNo)
+				results[firstArgument[index] + argNo].answer = static_cast<Answer>(answers[argNo]);
+	}
+
+	// non-optional sentinel checks settle an argument by themselves
+	vector<unsigned> worklist;
+	for (unsigned index = 0; index < functions.size(); ++index) {
+		const LocalSummary &function = *functions[index];
+		for (unsigned argNo = 0; argNo < function.arrays.size(); ++argNo) {
+			const unsigned slot = firstArgument[index] + argNo;
+			if (results[slot].answer == NULL_TERMINATED)
+				worklist.push_back(slot);
+			else if (function.arrays[argNo] && function.checks[argNo] == NonOptionalCheck) {
+				results[slot] = { NULL_TERMINATED, NonOptionalSentinelCheck, nullptr };
+				worklist.push_back(slot);
+			}
+		}
+	}
+
+	resolveCalls(worklist);
+
+	// NULL_TERMINATED flows from callee parameters back to every array
+	// argument reaching them; nothing else ever changes an answer, so
+	// one pass over the reversed call edges reaches the fixed point
+	const TraceScope tracing("propagate answers");
+	while (!worklist.empty()) {
+		const unsigned parameter = worklist.back();
+		worklist.pop_back();
+		const auto owner = upper_bound(firstArgument.begin(), firstArgument.end(), parameter) - 1;
+		const string &callee = functions[owner - firstArgument.begin()]->name;
+		for (const unsigned caller : dependentArguments[parameter])
+			if (results[caller].answer != NULL_TERMINATED) {
+				results[caller] = { NULL_TERMINATED, CalleeNullTerminated, &callee };
+				worklist.push_back(caller);
+			}
+	}
+
+	// any sentinel check at all rules out everything else
+	for (unsigned index = 0; index < functions.size(); ++index) {
+		const LocalSummary &function = *functions[index];
+		for (unsigned argNo = 0; argNo < function.arrays.size(); ++argNo) {
+			ArgumentResult &result = results[firstArgument[index] + argNo];
+			if (function.arrays[argNo] && result.answer == DONT_CARE && function.checks[argNo] != NoCheck)
+				result = { NON_NULL_TERMINATED, SentinelCheck, nullptr };
+		}
+	}
+}
+
+
+void Solver::write(raw_ostream &out) const {
+	out << "{\n\t\"library_functions\": {\n";
+	for (unsigned index = 0; index < functions.size(); ++index) {
+		const LocalSummary &function = *functions[index];
+		const ArgumentResult * const first = &results[firstArgument[index]];
+		const unsigned arity = function.arrays.size();
+		const auto writeArray = [&](const char key[], const std::function<void(unsigned)> &detail) {
+			out << "\t\t\t\"" << key << "\": [";
+			for (unsigned argNo = 0; argNo < arity; ++argNo) {
+				if (argNo)
+					out << ", ";
+				detail(argNo);
+			}
+			out << ']';
+		};
+
+		if (index)
+			out << ",\n";
+		out << "\t\t";
+		writeJSONString(out, function.name);
+		out << ": {\n";
+		writeArray("argument_names", [&](unsigned argNo) { writeJSONString(out, function.argumentNames[argNo]); });
+		out << ",\n";
+		writeArray("argument_annotations", [&](unsigned argNo) { out << first[argNo].answer; });
+		out << ",\n";
+		writeArray("args_array_receivers", [&](unsigned argNo) { out << function.arrays[argNo]; });
+		out << ",\n";
+		writeArray("argument_reasons", [&](unsigned argNo) {
+				const ArgumentResult &result = first[argNo];
+				writeJSONString(out, describeReason(result.reason, result.callee ? StringRef(*result.callee) : StringRef()));
+			});
+		out << "\n\t\t}";
+	}
+	out << "\n\t}\n}\n";
+}
+
+
+int main(int argc, char *argv[]) {
+	// write statistics and traces when finished
+	const llvm_shutdown_obj shutdown;
+	cl::ParseCommandLineOptions(argc, argv, "solve NullAnnotator results from local summaries\n");
+
+	try {
+		Dependencies dependencies;
+		dependencies.readCommandLine();
+
+		vector<ModuleSummary> modules(summaryFileNames.size());
+		parallelFor(threadCount, modules.size(), [&](size_t index) {
+				const TraceScope tracing("read local summaries", summaryFileNames[index]);
+				modules[index] = ModuleSummary::read(summaryFileNames[index]);
+			});
+
+		Solver solver(std::move(modules), dependencies);
+		solver.solve();
+
+		const TraceScope tracing("write results", outputFileName);
+		solver.write(*openOutputFile(outputFileName));
+	} catch (const exception &error) {
+		errs() << argv[0] << ": " << error.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef INCLUDE_STRONGLY_CONNECTED_HH
+#define INCLUDE_STRONGLY_CONNECTED_HH
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  Tarjan's strongly connected components over a graph of densely
+//  numbered nodes, using an explicit stack rather than recursion
+//
+//  Components come out in reverse topological order: every component
+//  appears after all components reachable from it.  For a call graph
+//  with edges from callers to callees, that means bottom-up.
+//
+
+typedef std::vector<std::vector<unsigned>> Components;
+
+template <typename Edges>
+Components stronglyConnectedComponents(const Edges &edges) {
+	const unsigned size = edges.size();
+	const unsigned unvisited = ~0u;
+	std::vector<unsigned> index(size, unvisited), lowlink(size);
+	std::vector<bool> onStack(size);
+	std::vector<unsigned> stack;
+	std::vector<std::pair<unsigned, unsigned>> frames;
+	unsigned counter = 0;
+	Components components;
+
+	const auto discover = [&](unsigned node) {
+		index[node] = lowlink[node] = counter++;
+		stack.push_back(node);
+		onStack[node] = true;
+		frames.emplace_back(node, 0);
+	};
+
+	for (unsigned root = 0; root < size; ++root) {
+		if (index[root] != unvisited) continue;
+		discover(root);
+
+		while (!frames.empty()) {
+			const unsigned node = frames.back().first;
+			const unsigned position = frames.back().second;
+
+			if (position < edges[node].size()) {
+				// descend into next successor, if not already seen
+				++frames.back().second;
+				const unsigned successor = edges[node][position];
+				if (index[successor] == unvisited)
+					discover(successor);
+				else if (onStack[successor])
+					lowlink[node] = std::min(lowlink[node], index[successor]);
+				continue;
+			}
+
+			// all successors done; node may be the root of a component
+			if (lowlink[node] == index[node]) {
+				components.emplace_back();
+				unsigned member;
+				do {
+					member = stack.back();
+					stack.pop_back();
+					onStack[member] = false;
+					components.back().push_back(member);
+				} while (member != node);
+				std::reverse(components.back().begin(), components.back().end());
+			}
+
+			frames.pop_back();
+			if (!frames.empty()) {
+				const unsigned parent = frames.back().first;
+				lowlink[parent] = std::min(lowlink[parent], lowlink[node]);
+			}
+		}
+	}
+
+	return components;
+}
+
+
+#endif // !INCLUDE_STRONGLY_CONNECTED_HH
@@ -0,0 +1,112 @@
+#include "StructuralHash.hh"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Constant.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+
+
+StructuralHash::StructuralHash()
+	: state(14695981039346656037ull) {
+}
+
+
+void StructuralHash::mix(const unsigned char *bytes, size_t count) {
+	for (const unsigned char *byte = bytes; byte != bytes + count; ++byte) {
+		state ^= *byte;
+		state *= 1099511628211ull;
+	}
+}
+
+
+StructuralHash &StructuralHash::operator<<(uint64_t number) {
+	// fixed little-endian byte order, so hashes survive across hosts
+	unsigned char bytes[8];
+	for (unsigned char &byte : bytes) {
+		byte = number & 0xff;
+		number >>= 8;
+	}
+	mix(bytes, sizeof(bytes));
+	return *this;
+}
+
+
+StructuralHash &StructuralHash::operator<<(StringRef text) {
+	*this << uint64_t(text.size());
+	mix(reinterpret_cast<const unsigned char *>(text.data()), text.size());
+	return *this;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+template <typename Printable>
+static uint64_t printedHash(const Printable &printable) {
+	string text;
+	raw_string_ostream stream(text);
+	printable.print(stream);
+	return (StructuralHash() << stream.str()).value();
+}
+
+
+uint64_t structuralHash(const Function &function) {
+	StructuralHash hash;
+
+	// type pointers differ from run to run, but printed types do not
+	DenseMap<const Type *, uint64_t> typeHashes;
+	const auto typeHash = [&](const Type &type) -> uint64_t {
+		const auto found = typeHashes.find(&type);
+		if (found != typeHashes.end())
+			return found->second;
+		const uint64_t result = printedHash(type);
+		typeHashes.insert(make_pair(&type, result));
+		return result;
+	};
+
+	// number every local value up front, as operands may refer forward
+	DenseMap<const Value *, uint64_t> locals;
+	for (const Argument &arg : function.getArgumentList())
+		locals.insert(make_pair(&arg, locals.size()));
+	for (const BasicBlock &block : function)
+		locals.insert(make_pair(&block, locals.size()));
+	for (const BasicBlock &block : function)
+		for (const Instruction &instruction : block)
+			locals.insert(make_pair(&instruction, locals.size()));
+
+	const auto hashOperand = [&](const Value &operand) {
+		const auto local = locals.find(&operand);
+		if (local != locals.end())
+			hash << 'L' << local->second;
+		else if (const GlobalValue * const global = dyn_cast<GlobalValue>(&operand))
+			hash << 'G' << global->getName();
+		else if (isa<Constant>(operand))
+			hash << 'C' << printedHash(operand);
+		else
+			// metadata and inline assembly
+			hash << 'M';
+	};
+
+	hash << function.getName() << typeHash(*function.getType());
+	for (const BasicBlock &block : function) {
+		hash << 'B' << uint64_t(block.size());
+		for (const Instruction &instruction : block) {
+			hash << instruction.getOpcode()
+			     << typeHash(*instruction.getType())
+			     << instruction.getRawSubclassOptionalData();
+			if (const CmpInst * const compare = dyn_cast<CmpInst>(&instruction))
+				hash << compare->getPredicate();
+			for (unsigned operand = 0; operand < instruction.getNumOperands(); ++operand)
+				hashOperand(*instruction.getOperand(operand));
+			if (const PHINode * const phi = dyn_cast<PHINode>(&instruction))
+				for (unsigned incoming = 0; incoming < phi->getNumIncomingValues(); ++incoming)
+					hashOperand(*phi->getIncomingBlock(incoming));
+		}
+	}
+
+	return hash.value();
+}
@@ -0,0 +1,51 @@
+#ifndef INCLUDE_STRUCTURAL_HASH_HH
+#define INCLUDE_STRUCTURAL_HASH_HH
+
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+
+namespace llvm {
+	class Function;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  64-bit FNV-1a hash accumulated from a stream of strings and integers
+//
+//  Strings are hashed along with their lengths, so that adjacent
+//  strings cannot run together into the same byte sequence.
+//
+
+class StructuralHash {
+public:
+	StructuralHash();
+
+	StructuralHash &operator<<(llvm::StringRef);
+	StructuralHash &operator<<(uint64_t);
+
+	uint64_t value() const;
+
+private:
+	uint64_t state;
+	void mix(const unsigned char *, size_t);
+};
+
+
+// hash of a function's code that stays stable from one run to the
+// next: local values are numbered by position rather than identified by
+// address, and types, globals, and constants are identified by how they
+// print; debug metadata is ignored
+uint64_t structuralHash(const llvm::Function &);
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline uint64_t StructuralHash::value() const {
+	return state;
+}
+
+
+#endif // !INCLUDE_STRUCTURAL_HASH_HH
@@ -0,0 +1,231 @@
+#include "Answer.hh"
+#include "JSONScanner.hh"
+#include "OutputFile.hh"
+#include "SummaryFile.hh"
+
+#include <cstring>
+#include <fstream>
+#include <llvm/Support/raw_ostream.h>
+#include <stdexcept>
+
+using namespace llvm;
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  file layout: header, open-addressed slot table of entry indexes,
+//  entry table, then a blob holding all names and answers
+//
+
+static const char signature[4] = { 'C', 'A', 'I', 'S' };
+static const uint32_t currentVersion = 1;
+static const uint32_t emptySlot = ~0u;
+
+
+struct SummaryFile::Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t entryCount;
+};
+
+
+struct SummaryFile::Entry {
+	uint32_t hash;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t answersOffset;
+	uint32_t arity;
+};
+
+
+// 32-bit FNV-1a
+static uint32_t hashName(StringRef name) {
+	uint32_t hash = 2166136261u;
+	for (const unsigned char c : name) {
+		hash ^= c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+SummaryFile::SummaryFile(const string &filename)
+	: mapping(filename),
+	  filename(filename) {
+	if (mapping.size() < sizeof(Header))
+		corrupt();
+	header = reinterpret_cast<const Header *>(mapping.data());
+	if (memcmp(header->magic, signature, sizeof(signature)) || header->version != currentVersion)
+		corrupt();
+
+	// slot count is a power of two, so probing can mask rather than divide
+	const uint64_t slotCount = header->slotCount;
+	const uint64_t tables = sizeof(Header) + slotCount * sizeof(uint32_t) + uint64_t(header->entryCount) * sizeof(Entry);
+	if (slotCount == 0 || (slotCount & (slotCount - 1)) || tables > mapping.size())
+		corrupt();
+
+	slots = reinterpret_cast<const uint32_t *>(header + 1);
+	entries = reinterpret_cast<const Entry *>(slots + slotCount);
+	blob = reinterpret_cast<const char *>(entries + header->entryCount);
+
+	// check everything lookups rely on now, so that they cannot fail
+	// later, deep inside some pass; this reads each byte once, far
+	// less than parsing the same results as JSON
+	bool anyEmpty = false;
+	for (const uint32_t index : makeArrayRef(slots, header->slotCount))
+		if (index == emptySlot)
+			anyEmpty = true;
+		else if (index >= header->entryCount)
+			corrupt();
+	// a table written by write() always has some empty slot to end
+	// probing, but a damaged one might not
+	if (!anyEmpty)
+		corrupt();
+
+	const size_t blobSize = mapping.data() + mapping.size() - blob;
+	for (const Entry &entry : makeArrayRef(entries, header->entryCount)) {
+		if (uint64_t(entry.nameOffset) + entry.nameLength > blobSize
+		    || uint64_t(entry.answersOffset) + entry.arity > blobSize)
+			corrupt();
+		for (const char answer : StringRef(blob + entry.answersOffset, entry.arity))
+			if (uint8_t(answer) > NULL_TERMINATED)
+				corrupt();
+	}
+}
+
+
+bool SummaryFile::recognize(const string &filename) {
+	char magic[sizeof(signature)];
+	ifstream in(filename, ios::binary);
+	return in.read(magic, sizeof(magic)) && !memcmp(magic, signature, sizeof(signature));
+}
+
+
+void SummaryFile::corrupt() const {
+	throw runtime_error("malformed binary summary file " + filename);
+}
+
+
+size_t SummaryFile::size() const {
+	return header->entryCount;
+}
+
+
+bool SummaryFile::lookup(StringRef name, ArrayRef<uint8_t> &answers) const {
+	const uint32_t hash = hashName(name);
+	const uint32_t mask = header->slotCount - 1;
+
+	// the constructor found some empty slot, so probing always ends
+	for (uint32_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+		const uint32_t index = slots[slot];
+		if (index == emptySlot)
+			return false;
+
+		const Entry &entry = entries[index];
+		if (entry.hash != hash || entry.nameLength != name.size())
+			continue;
+		if (StringRef(blob + entry.nameOffset, entry.nameLength) != name)
+			continue;
+
+		answers = ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(blob + entry.answersOffset), entry.arity);
+		return true;
+	}
+}
+
+
+void SummaryFile::write(const string &filename, const vector<Summary> &summaries) {
+	write(*openOutputFile(filename), summaries);
+}
+
+
+void SummaryFile::write(raw_ostream &out, const vector<Summary> &summaries) {
+	// at most half full, so probe sequences stay short
+	uint32_t slotCount = 1;
+	while (slotCount < 2 * summaries.size())
+		slotCount *= 2;
+
+	vector<uint32_t> slotTable(slotCount, emptySlot);
+	vector<Entry> entryTable;
+	string blobData;
+	entryTable.reserve(summaries.size());
+
+	for (const Summary &summary : summaries) {
+		const uint32_t hash = hashName(summary.name);
+		const Entry entry = {
+			hash,
+			uint32_t(blobData.size()),
+			uint32_t(summary.name.size()),
+			uint32_t(blobData.size() + summary.name.size()),
+			uint32_t(summary.answers.size()),
+		};
+		blobData += summary.name;
+		blobData.append(summary.answers.begin(), summary.answers.end());
+
+		uint32_t slot = hash & (slotCount - 1);
+		while (slotTable[slot] != emptySlot)
+			slot = (slot + 1) & (slotCount - 1);
+		slotTable[slot] = entryTable.size();
+		entryTable.push_back(entry);
+	}
+
+	Header header;
+	memcpy(header.magic, signature, sizeof(signature));
+	header.version = currentVersion;
+	header.slotCount = slotCount;
+	header.entryCount = entryTable.size();
+
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(slotTable.data()), slotTable.size() * sizeof(uint32_t));
+	out.write(reinterpret_cast<const char *>(entryTable.data()), entryTable.size() * sizeof(Entry));
+	out.write(blobData.data(), blobData.size());
+}
+
+
+vector<SummaryFile::Summary> SummaryFile::readJSON(const string &filename) {
+	const MappedFile contents(filename);
+	JSONScanner scanner(contents.contents());
+	vector<Summary> summaries;
+	unsigned unknown = 0;
+
+	scanner.enterObject();
+	StringRef key;
+	while (scanner.nextMember(key)) {
+		if (key != "library_functions") {
+			scanner.skipValue();
+			continue;
+		}
+
+		scanner.enterObject();
+		while (scanner.nextMember(key)) {
+			summaries.push_back({ key.str(), {} });
+			scanner.enterObject();
+			while (scanner.nextMember(key)) {
+				if (key != "argument_annotations") {
+					scanner.skipValue();
+					continue;
+				}
+				scanner.enterArray();
+				while (scanner.nextElement()) {
+					// hand-made answer files use further codes that
+					// NullAnnotator has no answer for
+					const int64_t answer = scanner.readInteger();
+					if (answer < DONT_CARE || answer > NULL_TERMINATED) {
+						++unknown;
+						summaries.back().answers.push_back(DONT_CARE);
+					} else
+						summaries.back().answers.push_back(answer);
+				}
+			}
+		}
+	}
+
+	if (unknown)
+		errs() << "warning: " << unknown << " argument annotations in " << filename
+		       << " are not NullAnnotator answers; reading them as don't care\n";
+	return summaries;
+}
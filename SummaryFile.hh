@@ -0,0 +1,69 @@
+#ifndef INCLUDE_SUMMARY_FILE_HH
+#define INCLUDE_SUMMARY_FILE_HH
+
+#include "MappedFile.hh"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm {
+	class raw_ostream;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  compact binary form of NullAnnotator results, for use as
+//  -dependency inputs without parsing JSON on every run
+//
+//  The file is memory-mapped and queried in place: a hashed index maps
+//  each function name to its packed per-argument Answer values, one
+//  byte per argument.  Integers are stored in host byte order.
+//
+//  The constructor checks the whole index and throws if the file is
+//  malformed, so lookups never fail, even inside passes.
+//
+
+class SummaryFile {
+public:
+	// one function's results, as written by write()
+	struct Summary {
+		std::string name;
+		std::vector<uint8_t> answers;
+	};
+
+	explicit SummaryFile(const std::string &filename);
+
+	// does this file start with the binary summary signature?
+	static bool recognize(const std::string &filename);
+
+	// answers for each argument of the named function, if present
+	bool lookup(llvm::StringRef name, llvm::ArrayRef<uint8_t> &answers) const;
+	size_t size() const;
+
+	static void write(const std::string &filename, const std::vector<Summary> &);
+	static void write(llvm::raw_ostream &, const std::vector<Summary> &);
+
+	// read NullAnnotator JSON results, such as answers-glib.json
+	static std::vector<Summary> readJSON(const std::string &filename);
+
+private:
+	const MappedFile mapping;
+	const std::string filename;
+
+	struct Header;
+	struct Entry;
+	const Header *header;
+	const uint32_t *slots;
+	const Entry *entries;
+	const char *blob;
+
+	[[noreturn]] void corrupt() const;
+};
+
+
+#endif // !INCLUDE_SUMMARY_FILE_HH
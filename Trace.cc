@@ -0,0 +1,117 @@
+#include "JSONWriter.hh"
+#include "OutputFile.hh"
+#include "Trace.hh"
+
+#include <atomic>
+#include <mutex>
+#include <system_error>
+#include <vector>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace std;
+using namespace std::chrono;
+
+
+string traceFileName;
+
+static cl::opt<string, true>
+	traceOutput("trace-output",
+		cl::location(traceFileName),
+		cl::value_desc("filename"),
+		cl::desc("File to write a timeline of analysis phases to, in Chrome trace-event format, when finished"));
+
+// timestamps count from when the plugin was loaded
+static const steady_clock::time_point epoch = steady_clock::now();
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  every span recorded so far; written from llvm_shutdown(), like
+//  LLVM's own statistics
+//
+
+namespace {
+	class TraceLog {
+	public:
+		~TraceLog();
+		void add(const char phase[], StringRef detail, steady_clock::time_point started, steady_clock::time_point finished);
+
+	private:
+		struct Event {
+			const char *phase;
+			string detail;
+			uint64_t start;
+			uint64_t duration;
+			unsigned thread;
+		};
+		vector<Event> events;
+		mutex eventsLock;
+		void write(raw_ostream &) const;
+	};
+}
+
+
+static ManagedStatic<TraceLog> traceLog;
+
+
+// small, stable numbers for threads, in order of first use
+static unsigned currentThread() {
+	static atomic<unsigned> threads(0);
+	static thread_local const unsigned thread = threads++;
+	return thread;
+}
+
+
+TraceLog::~TraceLog() {
+	if (traceFileName.empty()) return;
+	try {
+		write(*openOutputFile(traceFileName));
+	} catch (const system_error &error) {
+		errs() << "warning: " << error.what() << '\n';
+	}
+}
+
+
+void TraceLog::add(const char phase[], StringRef detail, steady_clock::time_point started, steady_clock::time_point finished) {
+	Event event = {
+		phase,
+		detail.str(),
+		static_cast<uint64_t>(duration_cast<microseconds>(started - epoch).count()),
+		static_cast<uint64_t>(duration_cast<microseconds>(finished - started).count()),
+		currentThread(),
+	};
+	const lock_guard<mutex> lock(eventsLock);
+	events.push_back(std::move(event));
+}
+
+
+void TraceLog::write(raw_ostream &out) const {
+	out << "{\"traceEvents\": [";
+	for (const Event &event : events) {
+		out << (&event == &events.front() ? "\n" : ",\n")
+		    << "{\"name\": ";
+		writeJSONString(out, event.phase);
+		out << ", \"cat\": \"analysis\", \"ph\": \"X\", \"pid\": 1"
+		    << ", \"tid\": " << event.thread
+		    << ", \"ts\": " << event.start
+		    << ", \"dur\": " << event.duration;
+		if (!event.detail.empty()) {
+			out << ", \"args\": {\"detail\": ";
+			writeJSONString(out, event.detail);
+			out << '}';
+		}
+		out << '}';
+	}
+	out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+void TraceScope::record() const {
+	traceLog->add(phase, detail, started, steady_clock::now());
+}
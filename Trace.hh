@@ -0,0 +1,79 @@
+#ifndef INCLUDE_TRACE_HH
+#define INCLUDE_TRACE_HH
+
+#include <llvm/ADT/StringRef.h>
+
+#include <chrono>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////
+//
+//  timed spans of analysis work, written in Chrome's trace-event format
+//  when LLVM shuts down if "-trace-output" names a file
+//
+//  Each span covers the lifetime of a TraceScope, or runs from open()
+//  to close().  When tracing is off, opening a span only tests one
+//  string for emptiness.  Spans may be recorded from several threads.
+//
+
+extern std::string traceFileName;
+
+
+class TraceScope {
+public:
+	TraceScope();
+	explicit TraceScope(const char phase[], llvm::StringRef detail = llvm::StringRef());
+	~TraceScope();
+
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+	// phase and detail must outlive the span
+	void open(const char phase[], llvm::StringRef detail = llvm::StringRef());
+	void close();
+
+private:
+	const char *phase;
+	llvm::StringRef detail;
+	std::chrono::steady_clock::time_point started;
+	void record() const;
+};
+
+
+////////////////////////////////////////////////////////////////////////
+
+
+inline TraceScope::TraceScope()
+	: phase(nullptr) {
+}
+
+
+inline TraceScope::TraceScope(const char phase[], llvm::StringRef detail)
+	: phase(nullptr) {
+	open(phase, detail);
+}
+
+
+inline TraceScope::~TraceScope() {
+	close();
+}
+
+
+inline void TraceScope::open(const char phase[], llvm::StringRef detail) {
+	close();
+	if (traceFileName.empty()) return;
+	this->phase = phase;
+	this->detail = detail;
+	started = std::chrono::steady_clock::now();
+}
+
+
+inline void TraceScope::close() {
+	if (!phase) return;
+	record();
+	phase = nullptr;
+}
+
+
+#endif // !INCLUDE_TRACE_HH
@@ -0,0 +1,208 @@
+#!/usr/bin/python
+
+'''
+Generate a synthetic LLVM module, plus matching iiglue results, for
+timing the analysis passes at scale.  Every shape that matters to the
+passes has its own knob: how many functions, how many loops each one
+has, how large each loop body is, how deep the phi webs feeding call
+operands are, and how deep and wide the call graph is.
+
+The module is written as LLVM 3.4/3.5 textual IR; assemble it with
+llvm-as before handing it to opt.
+'''
+
+from __future__ import print_function
+
+import argparse
+import json
+import random
+
+
+def parameters(arguments):
+	return ', '.join('i8* %%p%d' % index for index in range(arguments))
+
+
+class Function(object):
+	'''One generated function: a chain of call sites, then a chain of loops.'''
+
+	def __init__(self, options, rng, index, callees):
+		self.options = options
+		self.rng = rng
+		self.name = 'f%d' % index
+		self.callees = callees
+		self.lines = []
+
+	def emit(self, line):
+		self.lines.append(line)
+
+	def block(self, label):
+		self.emit('%s:' % label)
+
+	def segments(self):
+		calls = ['call%d.level0' % call if self.options.phi_depth else 'call%d.do' % call
+			 for call in range(len(self.callees))]
+		loops = ['loop%d.preheader' % loop for loop in range(self.options.loops)]
+		return calls + loops + ['done']
+
+	def phiWeb(self, call, following):
+		'''Merge arguments across phi_depth diamonds, one phi per callee parameter.'''
+		arguments = self.options.arguments
+		values = ['%%p%d' % parameter for parameter in range(arguments)]
+		for level in range(self.options.phi_depth):
+			prefix = 'call%d.level%d' % (call, level)
+			self.block(prefix)
+			self.emit('  %%%s.cond = icmp eq i8* %%p%d, null' % (prefix, level % arguments))
+			self.emit('  br i1 %%%s.cond, label %%%s.left, label %%%s.right' % (prefix, prefix, prefix))
+			for side in ('left', 'right'):
+				self.block('%s.%s' % (prefix, side))
+				self.emit('  br label %%%s.join' % prefix)
+			self.block('%s.join' % prefix)
+			merged = []
+			for parameter, value in enumerate(values):
+				other = '%%p%d' % ((parameter + level + 1) % arguments)
+				merged.append('%%%s.q%d' % (prefix, parameter))
+				self.emit('  %s = phi i8* [ %s, %%%s.left ], [ %s, %%%s.right ]' % (merged[-1], value, prefix, other, prefix))
+			values = merged
+			target = 'call%d.level%d' % (call, level + 1) if level + 1 < self.options.phi_depth else 'call%d.do' % call
+			self.emit('  br label %%%s' % target)
+
+		self.block('call%d.do' % call)
+		operands = ', '.join('i8* %s' % value for value in values)
+		self.emit('  call void @%s(%s)' % (self.callees[call], operands))
+		self.emit('  br label %%%s' % following)
+
+	def check(self, prefix, pointer, index, found, otherwise):
+		'''Load one element and leave the loop if it is the sentinel.'''
+		self.emit('  %%%s.addr = getelementptr inbounds i8* %s, i64 %s' % (prefix, pointer, index))
+		self.emit('  %%%s.element = load i8* %%%s.addr, align 1' % (prefix, prefix))
+		self.emit('  %%%s.sentinel = icmp eq i8 %%%s.element, 0' % (prefix, prefix))
+		self.emit('  br i1 %%%s.sentinel, label %%%s, label %%%s' % (prefix, found, otherwise))
+
+	def loop(self, loop, following):
+		'''A counted loop whose body is a chain of loop_blocks diamonds.
+
+		The sentinel check either sits in the header, where nothing can
+		bypass it, or in one arm of the first diamond, where the other
+		arm bypasses it.'''
+		options = self.options
+		prefix = 'loop%d' % loop
+		pointer = '%%p%d' % (loop % options.arguments)
+		index = '%%%s.index' % prefix
+		optional = options.loop_blocks > 0 and self.rng.random() < options.optional_checks
+		body = ['%s.body%d' % (prefix, block) for block in range(options.loop_blocks)] + ['%s.latch' % prefix]
+
+		self.block('%s.preheader' % prefix)
+		self.emit('  br label %%%s.header' % prefix)
+		self.block('%s.header' % prefix)
+		self.emit('  %s = phi i64 [ 0, %%%s.preheader ], [ %%%s.next, %%%s.latch ]' % (index, prefix, prefix, prefix))
+		if optional:
+			self.emit('  br label %%%s' % body[0])
+		else:
+			self.check(prefix, pointer, index, '%s.exit' % prefix, body[0])
+
+		for block in range(options.loop_blocks):
+			label = body[block]
+			self.block(label)
+			self.emit('  %%%s.cond = icmp ult i64 %s, %d' % (label, index, block + 1))
+			self.emit('  br i1 %%%s.cond, label %%%s.left, label %%%s.right' % (label, label, label))
+			self.block('%s.left' % label)
+			if optional and block == 0:
+				self.check(label, pointer, index, '%s.exit' % prefix, body[block + 1])
+			else:
+				self.emit('  br label %%%s' % body[block + 1])
+			self.block('%s.right' % label)
+			self.emit('  br label %%%s' % body[block + 1])
+
+		self.block('%s.latch' % prefix)
+		self.emit('  %%%s.next = add i64 %s, 1' % (prefix, index))
+		self.emit('  br label %%%s.header' % prefix)
+		self.block('%s.exit' % prefix)
+		self.emit('  br label %%%s' % following)
+
+	def generate(self):
+		self.emit('define void @%s(%s) {' % (self.name, parameters(self.options.arguments)))
+		segments = self.segments()
+		self.block('entry')
+		self.emit('  br label %%%s' % segments[0])
+		for call in range(len(self.callees)):
+			self.phiWeb(call, segments[call + 1])
+		for loop in range(self.options.loops):
+			self.loop(loop, segments[len(self.callees) + loop + 1])
+		self.block('done')
+		self.emit('  ret void')
+		self.emit('}')
+		return '\n'.join(self.lines)
+
+
+def callGraph(options, rng):
+	'''Split functions into call_depth layers; each calls fan_out functions in the next layer.'''
+	count = options.functions
+	depth = max(1, min(options.call_depth, count))
+	layers = [range(layer * count // depth, (layer + 1) * count // depth) for layer in range(depth)]
+	callees = [[] for _ in range(count)]
+	for layer, following in zip(layers, layers[1:]):
+		for caller in layer:
+			callees[caller] = [rng.choice(following) for _ in range(options.fan_out)]
+	# occasional calls back up the layers form recursive components
+	for caller in range(count):
+		if callees[caller] and rng.random() < options.back_edges:
+			callees[caller].append(rng.randrange(0, caller + 1))
+	return callees
+
+
+def generate(options):
+	'''Returns the module as textual IR, and iiglue results as a JSON-ready object.'''
+	rng = random.Random(options.seed)
+	callees = callGraph(options, rng)
+	functions = []
+	library = []
+	for index in range(options.functions):
+		names = ['f%d' % callee for callee in callees[index]]
+		functions.append(Function(options, rng, index, names).generate())
+		arrays = [rng.random() < options.array_density for _ in range(options.arguments)]
+		library.append({
+			'foreignFunctionName': 'f%d' % index,
+			'foreignFunctionParameters': [
+				{'parameterAnnotations': [{'PAArray': 1}] if array else []}
+				for array in arrays
+			],
+		})
+	settings = ' '.join('%s=%s' % setting for setting in sorted(vars(options).items()))
+	module = '; generated by GenerateWorkload.py: %s\n\n%s\n' % (settings, '\n\n'.join(functions))
+	return module, {'libraryFunctions': library}
+
+
+def argumentParser():
+	parser = argparse.ArgumentParser(description=__doc__.strip().split('\n\n')[0])
+	parser.add_argument('--functions', type=int, default=1000, help='number of functions')
+	parser.add_argument('--arguments', type=int, default=3, help='pointer arguments per function')
+	parser.add_argument('--array-density', type=float, default=0.5, help='fraction of arguments iiglue reports as arrays')
+	parser.add_argument('--loops', type=int, default=2, help='loops per function')
+	parser.add_argument('--loop-blocks', type=int, default=2, help='diamonds in each loop body, each adding three blocks')
+	parser.add_argument('--optional-checks', type=float, default=0.5, help='fraction of loops whose sentinel check can be bypassed')
+	parser.add_argument('--phi-depth', type=int, default=2, help='levels of phi nodes feeding each call operand')
+	parser.add_argument('--call-depth', type=int, default=8, help='layers in the call graph')
+	parser.add_argument('--fan-out', type=int, default=2, help='callees of each function outside the last layer')
+	parser.add_argument('--back-edges', type=float, default=0.05, help='chance of one extra call back up the layers, forming recursion')
+	parser.add_argument('--seed', type=int, default=0, help='random seed, for reproducible workloads')
+	return parser
+
+
+def main():
+	parser = argumentParser()
+	parser.add_argument('module', help='LLVM assembly (.ll) file to write')
+	parser.add_argument('iiglue', help='iiglue results (.json) file to write')
+	options = parser.parse_args()
+	if options.arguments < 1:
+		parser.error('--arguments must be at least 1')
+	module, iiglue = generate(options)
+	open(options.module, 'w').write(module)
+	json.dump(iiglue, open(options.iiglue, 'w'), indent=1)
+
+
+if __name__ == '__main__':
+	main()
+
+# Local variables:
+# indent-tabs-mode: t
+# End:
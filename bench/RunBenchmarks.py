@@ -0,0 +1,165 @@
+#!/usr/bin/python
+
+'''
+Time each analysis pass on synthetic workloads from GenerateWorkload.py.
+
+Passes compute most results lazily, so each stage runs the previous
+stage's pipeline plus one more pass with its "-eager" option where it
+has one, and that pass is charged with the difference.  Each pipeline
+runs several times and the fastest run counts.
+'''
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+import GenerateWorkload
+
+
+# each stage adds these arguments to everything before it; phi
+# backtracking is timed as part of ReachingArguments, which does it all
+STAGES = (
+	('parse', []),
+	('IIGlueReader', ['-iiglue-reader']),
+	('ReachingArguments', ['-reaching-arguments', '-reaching-arguments-eager']),
+	('FindSentinels', ['-function-analyses', '-find-sentinels', '-find-sentinels-eager']),
+	('NullAnnotator', ['-null-annotator']),
+)
+
+# generator settings for each named workload, on top of its defaults
+WORKLOADS = (
+	('small', 'functions=1000'),
+	('medium', 'functions=10000'),
+	('large', 'functions=50000'),
+	('deep-phi', 'functions=2000,phi-depth=32'),
+	('big-loops', 'functions=2000,loop-blocks=64'),
+	('many-loops', 'functions=2000,loops=32'),
+	('wide-calls', 'functions=2000,fan-out=16,call-depth=4'),
+	('recursive', 'functions=10000,back-edges=0.5'),
+	('dense-arrays', 'functions=10000,arguments=8,array-density=1'),
+)
+
+
+def workloadOptions(settings):
+	'''Parse key=value,... into generator options.'''
+	arguments = []
+	for setting in filter(None, settings.split(',')):
+		key, value = setting.split('=', 1)
+		arguments.append('--%s=%s' % (key, value))
+	return GenerateWorkload.argumentParser().parse_args(arguments)
+
+
+def prepare(name, settings, directory, assembler):
+	'''Generate one workload and assemble it; returns bitcode and iiglue filenames.'''
+	module, iiglue = GenerateWorkload.generate(workloadOptions(settings))
+	base = os.path.join(directory, name)
+	open(base + '.ll', 'w').write(module)
+	json.dump(iiglue, open(base + '.json', 'w'))
+	subprocess.check_call([assembler, base + '.ll', '-o', base + '.bc'])
+	return base + '.bc', base + '.json'
+
+
+def fastest(command, repeat):
+	best = None
+	with open(os.devnull, 'w') as sink:
+		for _ in range(repeat):
+			started = time.time()
+			subprocess.check_call(command, stdout=sink, stderr=sink)
+			elapsed = time.time() - started
+			best = elapsed if best is None else min(best, elapsed)
+	return best
+
+
+def measure(options, bitcode, iiglue):
+	'''Returns a list of (stage, seconds charged to that stage).'''
+	command = [options.opt, '-load', options.plugin, '-disable-output', '-iiglue-read-file', iiglue]
+	command += options.extra
+	results = []
+	previous = 0
+	for stage, arguments in STAGES:
+		command += arguments
+		total = fastest(command + [bitcode], options.repeat)
+		results.append((stage, max(0, total - previous)))
+		previous = total
+	return results
+
+
+def compare(results, baseline, tolerance, floor):
+	'''Returns descriptions of stages slower than the baseline allows.'''
+	regressions = []
+	for workload, stages in sorted(results.items()):
+		for stage, seconds in sorted(stages.items()):
+			before = baseline.get(workload, {}).get(stage)
+			if before is None:
+				continue
+			if seconds > before * (1 + tolerance) and seconds - before > floor:
+				regressions.append('%s %s: %.3f s, was %.3f s' % (workload, stage, seconds, before))
+	return regressions
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.strip().split('\n\n')[0])
+	parser.add_argument('--plugin', default='./CArrayIntrospection.so', help='analysis plugin to load')
+	parser.add_argument('--opt', default='opt', help='opt executable')
+	parser.add_argument('--llvm-as', default='llvm-as', help='llvm-as executable')
+	parser.add_argument('--repeat', type=int, default=3, help='runs of each pipeline; the fastest counts')
+	parser.add_argument('--workload', action='append', metavar='NAME[:KEY=VALUE,...]',
+			    help='workload to run; a known name alone, or a new name with generator settings; default all known workloads')
+	parser.add_argument('--extra', action='append', default=[], metavar='ARGUMENT', help='extra argument for every opt run, e.g. -null-annotator-threads=4')
+	parser.add_argument('--output', help='write per-stage seconds as JSON to this file')
+	parser.add_argument('--baseline', help='JSON written by an earlier --output; exit with failure on regressions')
+	parser.add_argument('--tolerance', type=float, default=0.25, help='allowed slowdown relative to the baseline')
+	parser.add_argument('--floor', type=float, default=0.05, help='slowdowns of fewer seconds than this are noise')
+	parser.add_argument('--keep', metavar='DIRECTORY', help='keep generated workloads in this directory')
+	options = parser.parse_args()
+
+	known = dict(WORKLOADS)
+	workloads = []
+	for workload in options.workload or [name for name, _ in WORKLOADS]:
+		name, _, settings = workload.partition(':')
+		if not settings and name not in known:
+			parser.error('unknown workload: %s' % name)
+		workloads.append((name, settings or known[name]))
+
+	directory = options.keep or tempfile.mkdtemp(prefix='bench-')
+	if options.keep and not os.path.isdir(directory):
+		os.makedirs(directory)
+
+	results = {}
+	try:
+		print('%-14s %-18s %10s' % ('workload', 'stage', 'seconds'))
+		for name, settings in workloads:
+			bitcode, iiglue = prepare(name, settings, directory, options.llvm_as)
+			results[name] = {}
+			for stage, seconds in measure(options, bitcode, iiglue):
+				results[name][stage] = seconds
+				print('%-14s %-18s %10.3f' % (name, stage, seconds))
+				sys.stdout.flush()
+	finally:
+		if not options.keep:
+			shutil.rmtree(directory)
+
+	if options.output:
+		json.dump(results, open(options.output, 'w'), indent=1, sort_keys=True)
+
+	if options.baseline:
+		regressions = compare(results, json.load(open(options.baseline)), options.tolerance, options.floor)
+		for regression in regressions:
+			print('regression:', regression)
+		if regressions:
+			sys.exit(1)
+
+
+if __name__ == '__main__':
+	main()
+
+# Local variables:
+# indent-tabs-mode: t
+# End:
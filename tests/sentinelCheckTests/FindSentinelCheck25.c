@@ -0,0 +1,32 @@
+/**
+ * This check tests several sentinel checks of several arguments in
+ * one loop, where each argument gets its own verdict.  Labels name
+ * the blocks holding each check.
+ *
+ * Both paths around the loop check a, so a cannot bypass its checks
+ * even though neither check lies on every path.  Only the left path
+ * checks b, so b can bypass its check.  Every path passes the check
+ * of c in join.
+ **/
+int scan(char a[], char b[], char c[], int flag) {
+	int i = 0;
+top:
+	if (flag > i)
+		goto left;
+	goto right;
+left:
+	if (a[i] == '\0')
+		return 1;
+leftB:
+	if (b[i] == '\0')
+		return 2;
+	goto join;
+right:
+	if (a[i] == '\0')
+		return 3;
+join:
+	if (c[i] == '\0')
+		return 4;
+	i++;
+	goto top;
+}
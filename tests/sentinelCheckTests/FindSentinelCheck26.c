@@ -0,0 +1,18 @@
+/**
+ * This check tests we detect a non-optional sentinel check
+ * in a loop nested inside another loop, where the outer loop
+ * has no sentinel check of its own.
+ *
+ * We expect to find one non-optional sentinel check, in the
+ * inner loop only.
+ **/
+int count(char string[], int rows) {
+	int total = 0;
+	for (int row = 0; row < rows; row++) {
+		int j = 0;
+		while (string[j] != '\0')
+			j++;
+		total += j;
+	}
+	return total;
+}
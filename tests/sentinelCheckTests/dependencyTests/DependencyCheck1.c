@@ -0,0 +1,9 @@
+/**
+ * consume is listed twice in the JSON dependency results, first as
+ * null terminated and then as don't care.  The first listing wins, so
+ * foo, which passes its string to consume, is null terminated too.
+ **/
+void consume(char *string);
+void foo(char string[]) {
+	consume(string);
+}
@@ -0,0 +1,8 @@
+/**
+ * Same as DependencyCheck1, but with the duplicated dependency results
+ * converted to a binary summary first.  The first listing still wins.
+ **/
+void consume(char *string);
+void foo(char string[]) {
+	consume(string);
+}
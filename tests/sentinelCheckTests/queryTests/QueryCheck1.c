@@ -0,0 +1,23 @@
+/**
+ * This test queries just foo.  foo passes its string to find, whose
+ * non-optional sentinel check makes both null terminated.  Only foo
+ * is reported: find is solved along the way, and bar, with a sentinel
+ * check of its own, is not reached at all.  foo's answer is asked for
+ * through NullAnnotator's lazy getAnswer, which solves find on demand.
+ **/
+int find(char string[]) {
+	for (int i = 0;; i++) {
+		if (string[i] == '\0')
+			break;
+	}
+	return 1;
+}
+int foo(char string[]) {
+	return find(string);
+}
+int bar(char string[]) {
+	int i = 0;
+	while (string[i] != '\0')
+		i++;
+	return i;
+}
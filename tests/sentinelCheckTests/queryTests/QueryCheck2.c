@@ -0,0 +1,12 @@
+/**
+ * This test queries a function that does not exist.  Nothing is
+ * solved, so nothing is reported, even though find has a
+ * non-optional sentinel check.
+ **/
+int find(char string[]) {
+	for (int i = 0;; i++) {
+		if (string[i] == '\0')
+			break;
+	}
+	return 1;
+}